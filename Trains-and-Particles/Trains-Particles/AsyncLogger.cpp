@@ -0,0 +1,179 @@
+/**
+ * @file AsyncLogger.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "AsyncLogger.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+AsyncLogger::AsyncLogger(const LoggerConfig& config)
+    : settings(config), mask(0), enqueuePos(0), dequeuePos(0), droppedCount(0), activeProducers(0), stopping(false), writerParked(false), wakeups(0), file(nullptr) {
+    size_t capacity = 2;
+    while (capacity < config.capacity) capacity *= 2; // Power of two so a slot is position & mask
+    ring = std::vector<Record>(capacity);
+    mask = capacity - 1;
+    for (size_t i = 0; i < capacity; i++) ring[i].sequence.store(i, std::memory_order_relaxed);
+
+    file = std::fopen(settings.path.c_str(), "w"); // Open a file for logging.
+    writer = std::thread(&AsyncLogger::writerLoop, this);
+}
+
+AsyncLogger::~AsyncLogger() {
+    stop();
+}
+
+// Bounded MPMC queue (D. Vyukov), used with a single consumer: a producer claims a slot with
+// one compare-exchange on enqueuePos, fills it, then publishes it by bumping its sequence.
+bool AsyncLogger::tryPush(const char* data, uint32_t length) {
+    uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+    while (true) {
+        Record& rec = ring[pos & mask];
+        uint64_t seq = rec.sequence.load(std::memory_order_acquire);
+        int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+        if (diff == 0) { // Slot is free for this position
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                rec.length = length;
+                std::memcpy(rec.text, data, length);
+                // seq_cst store then load: either the writer sees this record before it parks,
+                // or this producer sees writerParked and wakes it
+                rec.sequence.store(pos + 1, std::memory_order_seq_cst); // Visible to the writer
+                if (writerParked.load(std::memory_order_seq_cst)) {
+                    wakeups.fetch_add(1, std::memory_order_release);
+                    wakeups.notify_one();
+                }
+                return true;
+            }
+        }
+        else if (diff < 0) {
+            return false; // Ring is full: the writer has not consumed this slot yet
+        }
+        else {
+            pos = enqueuePos.load(std::memory_order_relaxed); // Another producer took it; retry
+        }
+    }
+}
+
+bool AsyncLogger::log(const std::string& message) {
+    uint32_t length = static_cast<uint32_t>(message.size() < MAX_MESSAGE ? message.size() : MAX_MESSAGE);
+    // Registered before stopping is checked (both seq_cst, as in stop()): either this call sees
+    // stopping and drops the message, or the writer sees it in flight and waits for it to finish
+    activeProducers.fetch_add(1, std::memory_order_seq_cst);
+    bool queued = false;
+    while (!stopping.load(std::memory_order_seq_cst)) {
+        if (tryPush(message.data(), length)) {
+            queued = true;
+            break;
+        }
+        if (settings.overflow == LogOverflow::Drop) break;
+        std::this_thread::yield(); // Backpressure: wait for the writer to make room
+    }
+    activeProducers.fetch_sub(1, std::memory_order_release);
+    if (!queued) droppedCount.fetch_add(1, std::memory_order_relaxed);
+    return queued;
+}
+
+size_t AsyncLogger::drain(std::vector<char>& batch) {
+    size_t count = 0;
+    while (true) {
+        Record& rec = ring[dequeuePos & mask];
+        if (rec.sequence.load(std::memory_order_acquire) != dequeuePos + 1) break; // Not yet published
+        batch.insert(batch.end(), rec.text, rec.text + rec.length);
+        batch.push_back('\n');
+        rec.sequence.store(dequeuePos + mask + 1, std::memory_order_release); // Free for the next lap
+        dequeuePos++;
+        count++;
+    }
+    return count;
+}
+
+void AsyncLogger::writerLoop() {
+    std::vector<char> batch;
+    batch.reserve((mask + 1) * 64); // Typical messages are short; grows at most once or twice
+    auto lastFlush = std::chrono::steady_clock::now();
+    bool dirty = false; // Written since the last flush
+    uint64_t reportedDrops = 0;
+
+    while (true) {
+        bool finishing = stopping.load(std::memory_order_acquire);
+        batch.clear();
+        size_t count = drain(batch);
+
+        uint64_t drops = droppedCount.load(std::memory_order_relaxed);
+        if (drops != reportedDrops) { // Leave a trace of lost messages in the log itself
+            std::string note = "[logger] " + std::to_string(drops - reportedDrops) + " message(s) dropped\n";
+            batch.insert(batch.end(), note.begin(), note.end());
+            reportedDrops = drops;
+        }
+
+        if (!batch.empty() && file) {
+            std::fwrite(batch.data(), 1, batch.size(), file); // One write for the whole batch
+            dirty = true;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        bool idle = count == 0;
+        if (dirty && file && (idle || settings.flushIntervalMs == 0 || now - lastFlush >= std::chrono::milliseconds(settings.flushIntervalMs))) {
+            std::fflush(file); // Also flush before parking, so nothing sits in the buffer while idle
+            lastFlush = now;
+            dirty = false;
+        }
+        if (!idle) continue;
+
+        if (finishing) {
+            // Done once no log() call is still in flight and every claimed slot has been written
+            if (activeProducers.load(std::memory_order_seq_cst) == 0 && dequeuePos == enqueuePos.load(std::memory_order_acquire)) break;
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Idle: park until a producer publishes a record or stop() is called
+        uint32_t ticket = wakeups.load(std::memory_order_acquire);
+        writerParked.store(true, std::memory_order_seq_cst);
+        bool ready = ring[dequeuePos & mask].sequence.load(std::memory_order_seq_cst) == dequeuePos + 1;
+        if (!ready && !stopping.load(std::memory_order_seq_cst)) wakeups.wait(ticket, std::memory_order_acquire);
+        writerParked.store(false, std::memory_order_relaxed);
+    }
+    if (file) std::fflush(file);
+}
+
+void AsyncLogger::stop() {
+    if (stopping.exchange(true)) return; // Already stopped
+    wakeups.fetch_add(1, std::memory_order_release);
+    wakeups.notify_one(); // The writer may be parked
+    if (writer.joinable()) writer.join();
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+//global variables for logging
+static LoggerConfig logger_config;
+static std::once_flag log_init_flag;
+static AsyncLogger* logger = nullptr; // Never deleted: threads that are still running at exit may log safely
+
+void configure_logging(const LoggerConfig& config) {
+    logger_config = config;
+}
+
+//log function
+static void initialize_logging() {
+    logger = new AsyncLogger(logger_config);
+    logger->log("Logging initialized.");
+    std::atexit(shutdown_logging); // Write out whatever is still queued when the program ends
+}
+
+// Function that logs messages.
+// It ensures that the logging is initialized before any message is logged.
+void log(const std::string& message) {
+    std::call_once(log_init_flag, initialize_logging); // Ensure initialization happens only once.
+    logger->log(message); // Queue the message; the writer thread writes it to the log file.
+}
+
+void shutdown_logging() {
+    if (logger) logger->stop();
+}
@@ -0,0 +1,79 @@
+/**
+ * @file AsyncLogger.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// How log() behaves when the ring buffer is full.
+enum class LogOverflow {
+    Drop, // Discard the message and count it (never blocks the caller)
+    Block // Wait until the writer thread has made room (no message is lost)
+};
+
+// Settings of the asynchronous logger; they must be set before the first message.
+struct LoggerConfig {
+    std::string path = "app.log"; // Log file
+    size_t capacity = 8192; // Records in the ring buffer (rounded up to a power of two); bounds memory use
+    LogOverflow overflow = LogOverflow::Drop; // Policy when the ring is full
+    int flushIntervalMs = 100; // Longest time a written record may sit in the stdio buffer (0 = flush every batch)
+};
+
+// AsyncLogger is a multi-producer, single-consumer logger. log() copies the message into a
+// fixed-size record of a bounded lock-free ring (no locks, no allocation, no system call),
+// and a background thread drains the ring in batches into one buffered file write. An idle
+// writer flushes and parks on an atomic wait; a producer only pays for a wake-up when it
+// finds the writer parked.
+class AsyncLogger {
+public:
+    static const size_t RECORD_SIZE = 256; // Bytes per record; longer messages are truncated
+    static const size_t MAX_MESSAGE = RECORD_SIZE - sizeof(uint32_t) - sizeof(uint64_t); // Usable text per record
+
+    explicit AsyncLogger(const LoggerConfig& config); // Constructor: Opens the file and starts the writer thread.
+    ~AsyncLogger(); // Destructor: Calls stop().
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    bool log(const std::string& message); // Queues one line. False if it was dropped (ring full with Drop, or stopped).
+    void stop(); // Drains every queued record, reports drops, flushes and closes. Later messages are dropped.
+    uint64_t dropped() const { return droppedCount.load(std::memory_order_relaxed); } // Messages dropped so far.
+
+private:
+    struct Record {
+        std::atomic<uint64_t> sequence; // Ring slot state (Vyukov bounded queue)
+        uint32_t length; // Bytes of text used
+        char text[MAX_MESSAGE]; // Preformatted message, without the newline
+    };
+
+    bool tryPush(const char* data, uint32_t length); // One attempt to claim a slot; false if the ring is full
+    size_t drain(std::vector<char>& batch); // Moves every ready record into batch; returns how many
+    void writerLoop(); // Background thread: drain, write, flush by policy
+
+    LoggerConfig settings; // Copy of the configuration
+    std::vector<Record> ring; // Fixed-size slots
+    size_t mask; // ring.size() - 1
+    alignas(64) std::atomic<uint64_t> enqueuePos; // Next slot producers claim (own cache line)
+    alignas(64) uint64_t dequeuePos; // Next slot the writer reads (only the writer touches it)
+    alignas(64) std::atomic<uint64_t> droppedCount; // Messages lost because the ring was full
+    alignas(64) std::atomic<uint32_t> activeProducers; // log() calls between their stopping check and their push
+    std::atomic<bool> stopping; // Tells the writer to finish
+    alignas(64) std::atomic<bool> writerParked; // Writer is (about to be) waiting on wakeups
+    std::atomic<uint32_t> wakeups; // Event count the parked writer waits on; bumped to wake it
+    FILE* file; // Log file (stdio buffering, written only by the writer thread)
+    std::thread writer; // Background writer thread
+};
+
+void configure_logging(const LoggerConfig& config); // Sets the logger options; call before the first log().
+void log(const std::string& message); // Queues a message for app.log (starts the logger on first use).
+void shutdown_logging(); // Stops the logger, writing out everything still queued (also run at exit).
+
+#endif // ASYNC_LOGGER_H
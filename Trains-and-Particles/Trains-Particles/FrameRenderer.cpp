@@ -0,0 +1,124 @@
+/**
+ * @file FrameRenderer.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "FrameRenderer.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Colour escape sequences, chosen by wall hit count exactly as in the original visualize_particles
+static const char CLEAR_SCREEN[] = "\x1B[2J\x1B[H";
+static const char COLOUR_WHITE[] = "\033[37m"; // Fewer than 3 hits
+static const char COLOUR_GREEN[] = "\033[32m"; // 3-4 hits
+static const char COLOUR_YELLOW[] = "\033[33m"; // 5-6 hits
+static const char COLOUR_RED[] = "\033[31m"; // 7 or more hits
+static const char COLOUR_RESET[] = "\033[0m";
+const size_t COLOUR_LENGTH = sizeof(COLOUR_WHITE) - 1; // All four colours have the same length
+const size_t RESET_LENGTH = sizeof(COLOUR_RESET) - 1;
+const size_t MAX_ID_LENGTH = 11; // "-2147483648"
+
+static const char* colour_for(int wallHits) {
+    if (wallHits < 3) return COLOUR_WHITE;
+    if (wallHits < 5) return COLOUR_GREEN;
+    if (wallHits < 7) return COLOUR_YELLOW;
+    return COLOUR_RED;
+}
+
+// Appends the decimal form of value at out; returns the number of characters written.
+static size_t append_int(char* out, int value) {
+    char digits[MAX_ID_LENGTH];
+    size_t n = 0;
+    unsigned int v = value < 0 ? 0u - static_cast<unsigned int>(value) : static_cast<unsigned int>(value);
+    do {
+        digits[n++] = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    size_t length = 0;
+    if (value < 0) out[length++] = '-';
+    while (n > 0) out[length++] = digits[--n];
+    return length;
+}
+
+FrameRenderer::FrameRenderer(int width, int height) : gridWidth(0), gridHeight(0), used(0) {
+    resize(width, height);
+}
+
+void FrameRenderer::resize(int width, int height) {
+    if (width == gridWidth && height == gridHeight) return;
+    gridWidth = width;
+    gridHeight = height;
+    cells.assign(static_cast<size_t>(width) * height, -1);
+    // Worst case: every cell holds a coloured particle id, plus a newline per row and the clear sequence
+    size_t maxCell = COLOUR_LENGTH + MAX_ID_LENGTH + RESET_LENGTH;
+    output.assign(sizeof(CLEAR_SCREEN) - 1 + static_cast<size_t>(height) * (static_cast<size_t>(width) * maxCell + 1), '\0');
+}
+
+const std::vector<char>& FrameRenderer::compose(const std::vector<Particle>& particles, bool clearScreen) {
+    const int width = gridWidth;
+    const int height = gridHeight;
+    std::fill(cells.begin(), cells.end(), -1);
+
+    // Plot each particle on the grid; in a shared cell the higher id hides the lower one, which
+    // is the later particle as before but does not change when the vector is reordered
+    for (size_t k = 0; k < particles.size(); k++) {
+        const Particle& p = particles[k];
+        int x = static_cast<int>((p.x + 10) / 20 * (width - 2)) + 1;
+        int y = static_cast<int>((p.y + 10) / 20 * (height - 2)) + 1;
+        if (x > 0 && x < width - 1 && y > 0 && y < height - 1) {
+            int32_t& cell = cells[x + y * width];
+            if (cell < 0 || particles[cell].id <= p.id) cell = static_cast<int32_t>(k);
+        }
+    }
+
+    char* out = output.data();
+    size_t n = 0;
+    if (clearScreen) {
+        std::memcpy(out, CLEAR_SCREEN, sizeof(CLEAR_SCREEN) - 1);
+        n += sizeof(CLEAR_SCREEN) - 1;
+    }
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (x == 0 || x == width - 1) out[n++] = '|'; // Left and right walls (also the corners)
+            else if (y == 0 || y == height - 1) out[n++] = '-'; // Top and bottom walls
+            else if (cells[x + y * width] < 0) out[n++] = ' ';
+            else {
+                const Particle& p = particles[cells[x + y * width]];
+                std::memcpy(out + n, colour_for(p.wallHits), COLOUR_LENGTH);
+                n += COLOUR_LENGTH;
+                n += append_int(out + n, p.id);
+                std::memcpy(out + n, COLOUR_RESET, RESET_LENGTH);
+                n += RESET_LENGTH;
+            }
+        }
+        out[n++] = '\n'; // New line at the end of each row
+    }
+    used = n;
+    return output;
+}
+
+void FrameRenderer::draw(const std::vector<Particle>& particles, bool clearScreen) {
+    compose(particles, clearScreen);
+    std::cout.flush(); // Anything already streamed must appear before the frame
+    write_stdout(output.data(), used);
+}
+
+void write_stdout(const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        int written = _write(1, data, static_cast<unsigned int>(size));
+#else
+        ssize_t written = ::write(STDOUT_FILENO, data, size);
+#endif
+        if (written <= 0) return; // Nothing sensible to do if the terminal is gone
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
@@ -0,0 +1,39 @@
+/**
+ * @file FrameRenderer.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef FRAME_RENDERER_H
+#define FRAME_RENDERER_H
+
+#include <vector>
+#include <cstdint>
+#include "Trains_and_Particles.h"
+
+// FrameRenderer draws the same picture as the original visualize_particles (walls, particle
+// ids coloured by wall hits), but without allocating per frame: the cell grid and the output
+// bytes live in buffers sized once for the worst case, colour escape sequences are constant,
+// and the finished frame is sent to the terminal with a single write().
+class FrameRenderer {
+public:
+    FrameRenderer(int width, int height); // Constructor: Allocates the buffers for a width x height grid.
+
+    void resize(int width, int height); // Reallocates the buffers (only when the size changes).
+    const std::vector<char>& compose(const std::vector<Particle>& particles, bool clearScreen); // Builds the frame bytes.
+    size_t frameSize() const { return used; } // Number of valid bytes produced by the last compose().
+    void draw(const std::vector<Particle>& particles, bool clearScreen); // compose() then one write() to stdout.
+
+    int width() const { return gridWidth; }
+    int height() const { return gridHeight; }
+
+private:
+    int gridWidth, gridHeight; // Size of the grid in cells, walls included
+    std::vector<int32_t> cells; // Index of the particle shown in each cell, -1 for empty
+    std::vector<char> output; // Frame bytes, sized for the worst case so it never grows
+    size_t used; // Bytes of output used by the current frame
+};
+
+// Writes size bytes to stdout with one system call (retrying only on partial writes).
+void write_stdout(const char* data, size_t size);
+
+#endif // FRAME_RENDERER_H
@@ -0,0 +1,37 @@
+/**
+ * @file Gate.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "Gate.h"
+
+void Gate::open() {
+    uint32_t expected = CLOSED;
+    if (state.compare_exchange_strong(expected, OPEN, std::memory_order_acq_rel)) {
+        state.notify_all();
+    }
+}
+
+void Gate::close() {
+    uint32_t expected = OPEN;
+    state.compare_exchange_strong(expected, CLOSED, std::memory_order_acq_rel);
+}
+
+void Gate::shutdown() {
+    state.store(SHUT_DOWN, std::memory_order_release);
+    state.notify_all();
+}
+
+void Gate::reset() {
+    state.store(CLOSED, std::memory_order_release);
+}
+
+bool Gate::wait() const {
+    uint32_t current = state.load(std::memory_order_acquire);
+    while (current == CLOSED) {
+        state.wait(CLOSED, std::memory_order_acquire); // Returns once the value is no longer CLOSED
+        current = state.load(std::memory_order_acquire);
+    }
+    return current == OPEN;
+}
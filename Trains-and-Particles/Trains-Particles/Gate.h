@@ -0,0 +1,32 @@
+/**
+ * @file Gate.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef GATE_H
+#define GATE_H
+
+#include <atomic>
+#include <cstdint>
+
+// Gate is a reusable open/closed signal for start/stop handshakes between threads, such as
+// Train A letting Train C move and Train B stopping it again. Waiters block on a single atomic
+// word (std::atomic::wait, a futex on Linux), so there is no mutex to take on either side and
+// open() wakes the waiters directly. shutdown() releases every waiter for good so that threads
+// blocked on the gate can exit; reset() makes the gate usable again for the next run.
+class Gate {
+public:
+    void open(); // Lets waiters through until close() (no effect after shutdown()).
+    void close(); // Makes the next wait() block (no effect after shutdown()).
+    void shutdown(); // Wakes every waiter; wait() returns false from now on.
+    void reset(); // Closed again, after a shutdown() too. No thread may be waiting.
+
+    bool wait() const; // Blocks while the gate is closed; true if open, false after shutdown().
+    bool isOpen() const { return state.load(std::memory_order_acquire) == OPEN; }
+
+private:
+    enum : uint32_t { CLOSED = 0, OPEN = 1, SHUT_DOWN = 2 };
+    std::atomic<uint32_t> state{ CLOSED };
+};
+
+#endif // GATE_H
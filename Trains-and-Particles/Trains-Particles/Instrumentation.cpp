@@ -0,0 +1,212 @@
+/**
+ * @file Instrumentation.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "Instrumentation.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+int LatencyHistogram::bucketOf(uint64_t ns) {
+    if (ns >= (1ull << MAX_BITS)) ns = (1ull << MAX_BITS) - 1;
+    if (ns < (1ull << SUB_BITS)) return static_cast<int>(ns);
+    int top = static_cast<int>(std::bit_width(ns)) - 1; // Index of the highest set bit (>= SUB_BITS)
+    int shift = top - SUB_BITS;
+    return ((shift + 1) << SUB_BITS) + static_cast<int>((ns >> shift) & ((1u << SUB_BITS) - 1));
+}
+
+uint64_t LatencyHistogram::bucketMidpoint(int bucket) {
+    if (bucket < (1 << SUB_BITS)) return static_cast<uint64_t>(bucket);
+    int shift = (bucket >> SUB_BITS) - 1;
+    uint64_t low = static_cast<uint64_t>((1 << SUB_BITS) + (bucket & ((1 << SUB_BITS) - 1))) << shift;
+    return low + ((1ull << shift) >> 1);
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    counts[bucketOf(ns)]++;
+    n++;
+    sum += ns;
+    if (ns < lo) lo = ns;
+    if (ns > hi) hi = ns;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int b = 0; b < BUCKETS; b++) counts[b] += other.counts[b];
+    n += other.n;
+    sum += other.sum;
+    if (other.n && other.lo < lo) lo = other.lo;
+    if (other.hi > hi) hi = other.hi;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    if (n == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * n + 0.5); // Values at or below the answer
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < BUCKETS; b++) {
+        seen += counts[b];
+        if (seen >= rank) return std::min(std::max(bucketMidpoint(b), min()), max()); // Never outside the exact range
+    }
+    return max();
+}
+
+// Global switch; relaxed is enough, a probe that misses the change only drops one value
+static std::atomic<bool> g_metricsEnabled(false);
+
+void set_metrics_enabled(bool enabled) {
+    g_metricsEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool metrics_enabled() {
+    return g_metricsEnabled.load(std::memory_order_relaxed);
+}
+
+uint64_t metrics_now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+namespace {
+
+// Histograms of one thread, allocated on its first value of each metric.
+struct ThreadMetrics {
+    std::array<std::unique_ptr<LatencyHistogram>, MAX_METRICS> histograms;
+};
+
+// Metric names and every thread's histograms. The mutex is only taken to register a name or a
+// thread, and when writing; threads that have exited keep their histograms here.
+struct MetricsRegistry {
+    std::mutex registryMutex;
+    std::vector<std::string> names; // Indexed by metric id
+    std::deque<ThreadMetrics> threads; // deque: registered entries never move
+};
+
+MetricsRegistry& registry() {
+    static MetricsRegistry instance; // Constructed on first use, before any probe records
+    return instance;
+}
+
+}
+
+int metric_id(const std::string& name) {
+    MetricsRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.registryMutex);
+    for (size_t id = 0; id < r.names.size(); id++) {
+        if (r.names[id] == name) return static_cast<int>(id);
+    }
+    if (r.names.size() >= static_cast<size_t>(MAX_METRICS)) return -1;
+    r.names.push_back(name);
+    return static_cast<int>(r.names.size() - 1);
+}
+
+void metric_record(int id, uint64_t ns) {
+    if (id < 0) return;
+    thread_local ThreadMetrics* mine = nullptr;
+    if (mine == nullptr) {
+        MetricsRegistry& r = registry();
+        std::lock_guard<std::mutex> lock(r.registryMutex);
+        r.threads.emplace_back();
+        mine = &r.threads.back();
+    }
+    std::unique_ptr<LatencyHistogram>& h = mine->histograms[id];
+    if (!h) h.reset(new LatencyHistogram());
+    h->record(ns);
+}
+
+bool write_metrics_json(const std::string& path, std::string& reason) {
+#if TP_INSTRUMENT
+    std::ofstream out(path);
+    if (!out) {
+        reason = "cannot open " + path + " for writing";
+        return false;
+    }
+    MetricsRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.registryMutex);
+    out << "{\n  \"threads\": " << r.threads.size() << ",\n  \"unit\": \"ns\",\n  \"metrics\": [";
+    bool firstMetric = true;
+    for (size_t id = 0; id < r.names.size(); id++) {
+        LatencyHistogram merged;
+        for (const ThreadMetrics& t : r.threads) {
+            if (t.histograms[id]) merged.merge(*t.histograms[id]);
+        }
+        if (merged.count() == 0) continue;
+
+        out << (firstMetric ? "\n" : ",\n") << "    {\"name\": \"" << r.names[id] << "\", \"count\": " << merged.count()
+            << ", \"total\": " << merged.total() << ", \"min\": " << merged.min() << ", \"mean\": " << merged.total() / merged.count()
+            << ", \"p50\": " << merged.percentile(50) << ", \"p90\": " << merged.percentile(90) << ", \"p99\": " << merged.percentile(99)
+            << ", \"p999\": " << merged.percentile(99.9) << ", \"max\": " << merged.max() << ",\n     \"per_thread\": [";
+        bool firstThread = true;
+        for (size_t t = 0; t < r.threads.size(); t++) {
+            const LatencyHistogram* h = r.threads[t].histograms[id].get();
+            if (h == nullptr) continue;
+            out << (firstThread ? "" : ", ") << "{\"thread\": " << t << ", \"count\": " << h->count() << ", \"total\": " << h->total() << "}";
+            firstThread = false;
+        }
+        out << "]}";
+        firstMetric = false;
+    }
+    out << "\n  ]\n}\n";
+    if (!out) {
+        reason = "error while writing " + path;
+        return false;
+    }
+    return true;
+#else
+    (void)path;
+    reason = "built without instrumentation (TP_INSTRUMENT=0)";
+    return false;
+#endif
+}
+
+MetricsReport::MetricsReport(const std::string& path) : path(path) {
+    if (!path.empty()) set_metrics_enabled(true);
+}
+
+MetricsReport::~MetricsReport() {
+    if (path.empty()) return;
+    set_metrics_enabled(false);
+    std::string reason;
+    if (write_metrics_json(path, reason)) std::cout << "Metrics written to " << path << std::endl;
+    else std::cerr << "Metrics not written: " << reason << std::endl;
+}
+
+#if TP_INSTRUMENT
+
+TimedMutex::TimedMutex(const char* name)
+    : waitMetric(metric_id(std::string(name) + ".wait")), holdMetric(metric_id(std::string(name) + ".hold")), heldSince(0) {
+}
+
+void TimedMutex::lock() {
+    if (!metrics_enabled()) {
+        mutex.lock();
+        heldSince = 0;
+        return;
+    }
+    uint64_t t0 = metrics_now_ns();
+    mutex.lock();
+    uint64_t t1 = metrics_now_ns();
+    metric_record(waitMetric, t1 - t0);
+    heldSince = t1;
+}
+
+bool TimedMutex::try_lock() {
+    if (!mutex.try_lock()) return false;
+    heldSince = metrics_enabled() ? metrics_now_ns() : 0;
+    return true;
+}
+
+void TimedMutex::unlock() {
+    uint64_t since = heldSince; // Read before unlocking: the next holder overwrites it
+    mutex.unlock();
+    if (since != 0) metric_record(holdMetric, metrics_now_ns() - since);
+}
+
+#endif // TP_INSTRUMENT
@@ -0,0 +1,135 @@
+/**
+ * @file Instrumentation.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <cstdint>
+
+// Build with TP_INSTRUMENT=0 (e.g. /D TP_INSTRUMENT=0 or -DTP_INSTRUMENT=0) to compile every probe
+// out: TP_SCOPED_TIMER expands to nothing and TimedMutex is a plain std::mutex. With probes
+// compiled in, they still record nothing until metrics are enabled (--metrics FILE).
+#ifndef TP_INSTRUMENT
+#define TP_INSTRUMENT 1
+#endif
+
+const int MAX_METRICS = 64; // Distinct metric names a run can use
+
+// Log-linear latency histogram in the style of HdrHistogram. Values below 32 ns get a bucket of
+// their own; above that, every power of two is split into 32 equal sub-buckets, so a recorded
+// value is known to within about 3%. Values are clamped to 2^44 ns (almost 5 hours).
+class LatencyHistogram {
+public:
+    static const int SUB_BITS = 5; // 32 sub-buckets per power of two
+    static const int MAX_BITS = 44; // Largest value: 2^44 - 1 ns
+    static const int BUCKETS = (MAX_BITS - SUB_BITS + 1) << SUB_BITS;
+
+    void record(uint64_t ns); // Adds one value.
+    void merge(const LatencyHistogram& other); // Adds every value of other.
+    uint64_t count() const { return n; } // Number of values recorded
+    uint64_t total() const { return sum; } // Sum of the values (exact, not bucketed)
+    uint64_t min() const { return n ? lo : 0; } // Smallest value (exact)
+    uint64_t max() const { return hi; } // Largest value (exact)
+    uint64_t percentile(double p) const; // Value at or below which p percent of the values fall (bucket midpoint).
+
+private:
+    static int bucketOf(uint64_t ns); // Bucket a value falls into
+    static uint64_t bucketMidpoint(int bucket); // Value reported for a bucket
+
+    std::array<uint64_t, BUCKETS> counts{}; // Values per bucket
+    uint64_t n = 0, sum = 0, lo = UINT64_MAX, hi = 0;
+};
+
+// Turns recording on or off at run time (off by default, so compiled-in probes cost one load).
+void set_metrics_enabled(bool enabled);
+bool metrics_enabled();
+
+// Id of the metric called name, registered on first use; -1 once MAX_METRICS names exist.
+int metric_id(const std::string& name);
+
+// Adds one value, in nanoseconds, to the calling thread's histogram of metric id. Each thread
+// records into its own histograms, so probes never contend; they are merged when written.
+void metric_record(int id, uint64_t ns);
+
+uint64_t metrics_now_ns(); // Steady-clock time in nanoseconds
+
+// Writes every metric with at least one value as JSON: merged count, total, min, mean, p50, p90,
+// p99, p99.9 and max in nanoseconds, plus count and total per thread. Call it once the threads
+// that record have been joined. Returns false and sets reason on failure.
+bool write_metrics_json(const std::string& path, std::string& reason);
+
+// Enables metrics for its lifetime when path is not empty, and writes them there when destroyed.
+class MetricsReport {
+public:
+    explicit MetricsReport(const std::string& path);
+    ~MetricsReport();
+
+    MetricsReport(const MetricsReport&) = delete;
+    MetricsReport& operator=(const MetricsReport&) = delete;
+
+private:
+    std::string path; // Output file ("" = metrics stay off)
+};
+
+#if TP_INSTRUMENT
+
+// Records the time from construction to destruction into one metric.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(int id) : id(id), start(metrics_enabled() ? metrics_now_ns() : 0) {}
+    ~ScopedTimer() {
+        if (start != 0) metric_record(id, metrics_now_ns() - start);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    int id; // Metric the time goes to
+    uint64_t start; // 0 when metrics were off at construction
+};
+
+// std::mutex that records how long lock() waited ("<name>.wait") and how long the lock was then
+// held ("<name>.hold"). Works with std::lock_guard and std::unique_lock.
+class TimedMutex {
+public:
+    explicit TimedMutex(const char* name = "mutex");
+
+    TimedMutex(const TimedMutex&) = delete;
+    TimedMutex& operator=(const TimedMutex&) = delete;
+
+    void lock();
+    bool try_lock();
+    void unlock();
+
+private:
+    std::mutex mutex; // The lock itself
+    int waitMetric, holdMetric; // Ids of "<name>.wait" and "<name>.hold"
+    uint64_t heldSince; // When the current holder got the lock (0 = not timed); only the holder touches it
+};
+
+#define TP_METRIC_CONCAT2(a, b) a##b
+#define TP_METRIC_CONCAT(a, b) TP_METRIC_CONCAT2(a, b)
+
+// Times the rest of the enclosing scope into the metric called name (a string literal).
+#define TP_SCOPED_TIMER(name) \
+    static const int TP_METRIC_CONCAT(tpMetricId, __LINE__) = metric_id(name); \
+    ScopedTimer TP_METRIC_CONCAT(tpScopedTimer, __LINE__)(TP_METRIC_CONCAT(tpMetricId, __LINE__))
+
+#else
+
+class TimedMutex : public std::mutex {
+public:
+    explicit TimedMutex(const char* = "mutex") {}
+};
+
+#define TP_SCOPED_TIMER(name) ((void)0)
+
+#endif // TP_INSTRUMENT
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,1162 @@
+/**
+ * @file ParticleBenchmark.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "ParticleBenchmark.h"
+#include "ParticleSoA.h"
+#include "ParticleCollisions.h"
+#include "FrameRenderer.h"
+#include "ParticleCheckpoint.h"
+#include "RailwayNetwork.h"
+#include "RailwayEventSim.h"
+#include "WorkerPool.h"
+#include "Instrumentation.h"
+#include "ParticlePipeline.h"
+#include "ParticleRng.h"
+#include "ParticleFastForward.h"
+#include "ParticleReorder.h"
+#include "TrackLock.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <latch>
+#include <random>
+#include <sstream>
+#include <thread>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Reads the value following option argv[i]; false if it is missing.
+static bool next_value(int argc, char* argv[], int& i, std::string& value) {
+    if (i + 1 >= argc) {
+        std::cerr << "Missing value for " << argv[i] << std::endl;
+        return false;
+    }
+    value = argv[++i];
+    return true;
+}
+
+bool parse_command_line(int argc, char* argv[], ParticleSimConfig& config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        std::string value;
+        if (arg == "--part2" || arg == "--run" || arg == "--network" || arg == "--headless" || arg == "--domain" || arg == "--bench-pool" || arg == "--bench-soa" || arg == "--bench-render" || arg == "--bench-pipeline" || arg == "--bench-steal" || arg == "--bench-align" || arg == "--bench-init" || arg == "--bench-fastforward" || arg == "--bench-morton" || arg == "--bench-kernels" || arg == "--bench-tracklock") {
+            config.mode = arg.substr(2);
+        }
+        else if (arg == "--particles") {
+            if (!next_value(argc, argv, i, value)) return false;
+            config.numParticles = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if (arg == "--steps") {
+            if (!next_value(argc, argv, i, value)) return false;
+            config.numSteps = std::atoi(value.c_str());
+        }
+        else if (arg == "--threads") {
+            if (!next_value(argc, argv, i, value)) return false;
+            config.numThreads = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if (arg == "--dt") {
+            if (!next_value(argc, argv, i, value)) return false;
+            config.dt = std::strtof(value.c_str(), nullptr);
+        }
+        else if (arg == "--kernel") {
+            if (!next_value(argc, argv, i, value)) return false;
+            if (value != "aos" && value != "soa" && value != "generic") {
+                std::cerr << "Unknown kernel: " << value << std::endl;
+                return false;
+            }
+            config.kernel = value;
+        }
+        else if (arg == "--dim") {
+            if (!next_value(argc, argv, i, value)) return false;
+            config.kernelChoice.dim = std::atoi(value.c_str());
+        }
+        else if (arg == "--scalar") {
+            if (!next_value(argc, argv, i, value)) return false;
+            if (value != "float" && value != "double") {
+                std::cerr << "Unknown scalar type: " << value << std::endl;
+                return false;
+            }
+            config.kernelChoice.doublePrecision = value == "double";
+        }
+        else if (arg == "--boundary") {
+            if (!next_value(argc, argv, i, value)) return false;
+            if (!parse_boundary_policy(value, config.kernelChoice.boundary)) {
+                std::cerr << "Unknown boundary policy: " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--tiles") {
+            if (!next_value(argc, argv, i, value)) return false;
+            size_t x = value.find('x');
+            config.domain.tilesX = std::atoi(value.substr(0, x).c_str());
+            config.domain.tilesY = x == std::string::npos ? 0 : std::atoi(value.substr(x + 1).c_str());
+        }
+        else if (arg == "--ring-capacity") {
+            if (!next_value(argc, argv, i, value)) return false;
+            config.domain.ringCapacity = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if (arg == "--width") {
+            if (!next_value(argc, argv, i, value)) return false;
+            config.width = std::atoi(value.c_str());
+        }
+        else if (arg == "--height") {
+            if (!next_value(argc, argv, i, value)) return false;
+            config.height = std::atoi(value.c_str());
+        }
+        else if (arg == "--metrics") {
+            if (!next_value(argc, argv, i, config.metricsPath)) return false;
+        }
+        else if (arg == "--rng") {
+            if (!next_value(argc, argv, i, value)) return false;
+            if (!parse_particle_rng(value, config.rng)) {
+                std::cerr << "Unknown random number generator: " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--aligned") {
+            config.alignedPartitions = true;
+        }
+        else if (arg == "--reorder") {
+            if (!next_value(argc, argv, i, value)) return false;
+            config.reorderEvery = std::atoi(value.c_str());
+        }
+        else if (arg == "--depth") {
+            if (!next_value(argc, argv, i, value)) return false;
+            config.pipelineDepth = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if (arg == "--checkpoint") {
+            if (!next_value(argc, argv, i, config.checkpointPath)) return false;
+        }
+        else if (arg == "--checkpoint-every") {
+            if (!next_value(argc, argv, i, value)) return false;
+            config.checkpointEvery = std::atoi(value.c_str());
+        }
+        else if (arg == "--resume") {
+            if (!next_value(argc, argv, i, config.resumePath)) return false;
+        }
+        else if (arg == "--trajectory") {
+            if (!next_value(argc, argv, i, config.trajectoryPath)) return false;
+        }
+        else if (arg == "--trajectory-every") {
+            if (!next_value(argc, argv, i, value)) return false;
+            config.trajectoryEvery = std::atoi(value.c_str());
+        }
+        else if (arg == "--log-overflow") {
+            if (!next_value(argc, argv, i, value)) return false;
+            if (value != "drop" && value != "block") {
+                std::cerr << "Unknown log overflow policy: " << value << std::endl;
+                return false;
+            }
+            config.logging.overflow = value == "drop" ? LogOverflow::Drop : LogOverflow::Block;
+        }
+        else if (arg == "--log-flush-ms") {
+            if (!next_value(argc, argv, i, value)) return false;
+            config.logging.flushIntervalMs = std::atoi(value.c_str());
+        }
+        else if (arg == "--log-capacity") {
+            if (!next_value(argc, argv, i, value)) return false;
+            config.logging.capacity = std::strtoull(value.c_str(), nullptr, 10);
+        }
+        else if (arg == "--event-log" || arg == "--validate-log") {
+            if (!next_value(argc, argv, i, value)) return false;
+            config.eventLogPath = value;
+            if (arg == "--validate-log") config.mode = "validate-log";
+        }
+        else if (arg == "--des") {
+            config.discreteEvent = true;
+        }
+        else if (arg == "--trains" || arg == "--sections" || arg == "--route-length" || arg == "--sections-per-route"
+                 || arg == "--seed" || arg == "--step-ms") {
+            if (!next_value(argc, argv, i, value)) return false;
+            int n = std::atoi(value.c_str());
+            if (arg == "--trains") config.numTrains = n;
+            else if (arg == "--sections") config.numSections = n;
+            else if (arg == "--route-length") config.routeLength = n;
+            else if (arg == "--sections-per-route") config.sectionsPerRoute = n;
+            else if (arg == "--seed") config.seed = static_cast<unsigned>(n);
+            else config.stepMillis = n;
+        }
+        else if (arg == "--track-lock") {
+            if (!next_value(argc, argv, i, value)) return false;
+            if (!parse_track_lock_policy(value, config.trackLock)) {
+                std::cerr << "Unknown track lock policy: " << value << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--occupancy") {
+            if (!next_value(argc, argv, i, value)) return false;
+            config.occupancy = std::atoi(value.c_str());
+        }
+        else if (arg == "--radius") {
+            if (!next_value(argc, argv, i, value)) return false;
+            config.collisionRadius = std::strtof(value.c_str(), nullptr);
+        }
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (config.numParticles == 0 || config.numSteps <= 0 || config.numThreads == 0) {
+        std::cerr << "--particles, --steps and --threads must be greater than zero" << std::endl;
+        return false;
+    }
+    if (config.width < 3 || config.height < 3) {
+        std::cerr << "--width and --height must be at least 3" << std::endl;
+        return false;
+    }
+    if (config.pipelineDepth == 0) {
+        std::cerr << "--depth must be greater than zero" << std::endl;
+        return false;
+    }
+    if (config.numTrains < 0 || config.numSections <= 0 || config.numSections > UINT16_MAX || config.routeLength < 3 || config.sectionsPerRoute < 0 || config.stepMillis < 0) {
+        std::cerr << "Invalid railway network parameters" << std::endl;
+        return false;
+    }
+    if (config.occupancy < 1) {
+        std::cerr << "--occupancy must be at least 1" << std::endl;
+        return false;
+    }
+    if (config.kernelChoice.dim != 2 && config.kernelChoice.dim != 3) {
+        std::cerr << "--dim must be 2 or 3" << std::endl;
+        return false;
+    }
+    if (config.domain.tilesX <= 0 || config.domain.tilesY <= 0 || config.domain.tilesX * config.domain.tilesY > 64 || config.domain.ringCapacity == 0) {
+        std::cerr << "--tiles must be AxB with 1 to 64 tiles in all (one ring per pair of tiles), and --ring-capacity greater than zero" << std::endl;
+        return false;
+    }
+    if (config.reorderEvery < 0) {
+        std::cerr << "--reorder must be >= 0" << std::endl;
+        return false;
+    }
+    if (config.checkpointEvery < 0 || config.trajectoryEvery <= 0) {
+        std::cerr << "--checkpoint-every must be >= 0 and --trajectory-every > 0" << std::endl;
+        return false;
+    }
+    if (config.collisionRadius > 0 && config.kernel != "aos" && config.mode == "headless") {
+        std::cerr << "--radius needs --kernel aos (collisions run on the Particle vector)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void print_usage(const char* program) {
+    std::cout << "Usage: " << program << " [--part2 | --run | --network | --headless | --domain | --bench-pool | --bench-soa | --bench-render | --bench-pipeline | --bench-steal | --bench-align | --bench-init | --bench-fastforward | --bench-morton | --bench-kernels | --bench-tracklock] [options]\n"
+              << "  --particles N   number of particles (default " << NUM_PARTICLES << ")\n"
+              << "  --steps S       number of simulation steps (default " << NUM_STEPS << ")\n"
+              << "  --threads T     maximum number of worker threads (default " << NUM_THREADS << ")\n"
+              << "  --dt DT         time step (default " << DT << ")\n"
+              << "  --kernel K      headless update kernel: aos, soa or generic (default soa)\n"
+              << "  --dim D, --scalar float|double, --boundary reflect|wrap|absorb   generic kernel instantiation (2, float, reflect)\n"
+              << "  --width W       bench-render grid width (default " << WIDTH << ")\n"
+              << "  --height H      bench-render grid height (default " << HEIGHT << ")\n"
+              << "  --depth D       bench-pipeline: frames in flight between the pipeline stages (default 4)\n"
+              << "  --rng G         headless: mt19937 (same start as Part 2) or philox (counter-based) (default mt19937)\n"
+              << "  --aligned       headless aos: align worker ranges to cache lines\n"
+              << "  --reorder K     headless aos, bench-morton: sort the particles into Morton order every K steps (default 0 = never)\n"
+              << "  --radius R      particle radius for collisions, aos kernel only (default " << COLLISION_RADIUS << " = off)\n"
+              << "  --tiles AxB     domain: split the box into A x B tiles, one worker process each (default 2x2)\n"
+              << "  --ring-capacity N  domain: particles per shared-memory ring between two tiles (default 1024)\n"
+              << "  --checkpoint F  run: write a checkpoint to F every --checkpoint-every K steps and at the end\n"
+              << "  --resume F      run: continue from checkpoint F up to --steps total steps\n"
+              << "  --trajectory F  run: stream positions to F every --trajectory-every K steps\n"
+              << "  --log-overflow P  app.log policy when the log ring is full: drop or block (default drop)\n"
+              << "  --log-flush-ms MS flush app.log at most every MS milliseconds, 0 = every batch (default 100)\n"
+              << "  --log-capacity N  records in the log ring buffer (default 8192)\n"
+              << "  --trains N      network: generated trains (default 0 = classic Train A/B layout)\n"
+              << "  --sections M    network: shared sections (default 4)\n"
+              << "  --route-length L, --sections-per-route K, --seed S   network: route generator (25, 3, 12345)\n"
+              << "  --step-ms MS    network: wall time per train move (default 0)\n"
+              << "  --des           network: discrete-event run on a virtual clock instead of threads\n"
+              << "  --track-lock P  default, network: guard of the shared sections: mutex, ticket, mcs or semaphore (default mutex)\n"
+              << "  --occupancy K   bench-tracklock: trains the semaphore policy lets into the section at once (default 2)\n"
+              << "  --event-log F   network: also write the log to F as compact binary records and validate the file\n"
+              << "  --validate-log F  stream-validate the binary event log F\n"
+              << "  --metrics F     any mode: time the hot paths and write per-thread histograms to F as JSON\n"
+              << "--part2 runs the visualised particle simulation (Part 2) with the built-in constants.\n"
+              << "Without a mode the railway simulation (Part 1) runs as before.\n";
+}
+
+// Result of one headless run.
+struct HeadlessResult {
+    double seconds; // Wall time of the step loop only (initialisation excluded)
+    long long wallHits; // Sum of wallHits over all particles
+    long long collisions; // Particle-particle collisions resolved during the run
+};
+
+// Runs config.numSteps steps on numThreads pooled workers with the chosen kernel.
+static HeadlessResult run_headless_once(const ParticleSimConfig& config, size_t numThreads) {
+    HeadlessResult result = { 0.0, 0, 0 };
+    WorkerPool pool(numThreads);
+
+    if (config.kernel == "aos") {
+        std::vector<Particle> particles(config.numParticles);
+        for (size_t i = 0; i < particles.size(); i++) particles[i] = Particle(static_cast<int>(i));
+        initialize_particles_parallel(particles, pool, config.rng);
+        SpatialGrid grid(2 * config.collisionRadius);
+        MortonReorder reorder;
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (int step = 0; step < config.numSteps; step++) {
+            if (config.reorderEvery > 0 && step % config.reorderEvery == 0) reorder.reorder(particles, pool);
+            auto update = [&](size_t, size_t start, size_t end) {
+                update_particles(particles, config.dt, start, end);
+            };
+            {
+                TP_SCOPED_TIMER("particles.update");
+                if (config.alignedPartitions) pool.runAlignedStep(particles, update);
+                else pool.runIndexedStep(particles.size(), update);
+            }
+            if (config.collisionRadius > 0) {
+                result.collisions += collide_particles(particles, config.collisionRadius, grid, pool);
+            }
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        for (const auto& p : particles) result.wallHits += p.wallHits;
+    }
+    else if (config.kernel == "generic") {
+        GenericRunResult r = run_generic_particles(config.kernelChoice, config.numParticles, config.numSteps, config.dt, pool, config.rng);
+        result.seconds = r.seconds;
+        result.wallHits = r.wallHits;
+    }
+    else {
+        ParticleSoA particles;
+        initialize_particles_soa_parallel(particles, config.numParticles, pool, config.rng);
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (int step = 0; step < config.numSteps; step++) {
+            TP_SCOPED_TIMER("particles.update");
+            pool.runStep(particles.size(), [&](size_t start, size_t end) {
+                update_particles_soa(particles, config.dt, start, end);
+            });
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        for (int hits : particles.wallHits) result.wallHits += hits;
+    }
+    return result;
+}
+
+void run_headless_benchmark(const ParticleSimConfig& config) {
+    std::cout << "Headless particle benchmark\n";
+    std::cout << "Number of Particles: " << config.numParticles << std::endl;
+    std::cout << "Time Step (DT): " << config.dt << std::endl;
+    std::cout << "Number of Simulation Steps: " << config.numSteps << std::endl;
+    std::cout << "Maximum Number of Threads: " << config.numThreads << std::endl;
+    std::string kernelName = config.kernel == "aos" ? "AoS scalar" : std::string("SoA ") + soa_kernel_isa();
+    if (config.kernel == "generic") {
+        kernelName = "generic " + std::to_string(config.kernelChoice.dim) + "D " + (config.kernelChoice.doublePrecision ? "double " : "float ")
+                   + boundary_policy_name(config.kernelChoice.boundary);
+    }
+    std::cout << "Kernel: " << kernelName
+              << (config.kernel == "aos" && config.alignedPartitions ? ", cache-line-aligned ranges" : "")
+              << (config.kernel == "aos" && config.reorderEvery > 0 ? ", Morton reorder every " + std::to_string(config.reorderEvery) + " steps" : "") << std::endl;
+    std::cout << "Collision Radius: " << config.collisionRadius << std::endl;
+    std::cout << "Random numbers: " << particle_rng_name(config.rng) << std::endl;
+    std::cout << "Hardware threads: " << std::thread::hardware_concurrency() << "\n\n";
+
+    // Thread counts 1, 2, 4, ... plus the requested maximum
+    std::vector<size_t> threadCounts;
+    for (size_t t = 1; t < config.numThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(config.numThreads);
+
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "seconds" << std::setw(18) << "ns/particle/step"
+              << std::setw(14) << "wallHits" << std::setw(12) << "collisions" << std::setw(10) << "speedup" << std::setw(12) << "efficiency" << std::endl;
+
+    double baseSeconds = 0.0;
+    long long baseHits = 0, baseCollisions = 0;
+    for (size_t threads : threadCounts) {
+        HeadlessResult r = run_headless_once(config, threads);
+        if (threads == threadCounts.front()) {
+            baseSeconds = r.seconds;
+            baseHits = r.wallHits;
+            baseCollisions = r.collisions;
+        }
+        double nsPerParticleStep = r.seconds * 1e9 / (static_cast<double>(config.numParticles) * config.numSteps);
+        double speedup = baseSeconds / r.seconds;
+
+        std::cout << std::setw(8) << threads << std::setw(14) << std::fixed << std::setprecision(4) << r.seconds
+                  << std::setw(18) << std::setprecision(3) << nsPerParticleStep << std::setw(14) << r.wallHits << std::setw(12) << r.collisions
+                  << std::setw(10) << std::setprecision(2) << speedup << std::setw(11) << std::setprecision(1) << 100.0 * speedup / threads << "%";
+        if (r.wallHits != baseHits || r.collisions != baseCollisions) std::cout << "  (results differ from 1 thread!)";
+        std::cout << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+    }
+}
+
+void run_resumable_simulation(const ParticleSimConfig& config) {
+    std::string reason;
+    ParticleCheckpoint state;
+    WorkerPool pool(config.numThreads);
+
+    if (!config.resumePath.empty()) {
+        if (!load_checkpoint(config.resumePath, state, reason)) {
+            std::cerr << "Cannot resume: " << reason << std::endl;
+            return;
+        }
+        std::cout << "Resumed " << state.particles.size() << " particles at step " << state.step << " from " << config.resumePath << std::endl;
+    }
+    else {
+        state.dt = config.dt;
+        state.particles.resize(config.numParticles);
+        for (size_t i = 0; i < state.particles.size(); i++) state.particles[i] = Particle(static_cast<int>(i));
+        state.gen.seed(12345); // Same fixed seed as initialize_particles
+        initialize_particles_parallel(state.particles, pool, state.gen); // Always mt19937: its state goes into the checkpoint
+    }
+
+    TrajectoryWriter trajectory;
+    if (!config.trajectoryPath.empty()) {
+        bool resumed = !config.resumePath.empty(); // A resumed run extends the earlier trajectory from its checkpoint
+        bool opened = resumed
+            ? trajectory.resume(config.trajectoryPath, state.particles.size(), config.trajectoryEvery, state.step, reason)
+            : trajectory.open(config.trajectoryPath, state.particles.size(), config.trajectoryEvery, reason);
+        if (!opened) {
+            std::cerr << reason << std::endl;
+            return;
+        }
+        if (!resumed) trajectory.record(0, state.particles); // Frame of the initial state
+    }
+
+    SpatialGrid grid(2 * config.collisionRadius);
+    auto t0 = std::chrono::steady_clock::now();
+    while (state.step < static_cast<uint64_t>(config.numSteps)) {
+        pool.runStep(state.particles.size(), [&](size_t start, size_t end) {
+            update_particles(state.particles, state.dt, start, end);
+        });
+        if (config.collisionRadius > 0) collide_particles(state.particles, config.collisionRadius, grid, pool);
+        state.step++;
+
+        trajectory.record(state.step, state.particles);
+        bool periodic = config.checkpointEvery > 0 && state.step % config.checkpointEvery == 0;
+        if (!config.checkpointPath.empty() && (periodic || state.step == static_cast<uint64_t>(config.numSteps))) {
+            if (!save_checkpoint(config.checkpointPath, state, reason)) {
+                std::cerr << "Checkpoint failed: " << reason << std::endl;
+                trajectory.close(); // Keep the frames written so far
+                return;
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    trajectory.close();
+
+    long long wallHits = 0, collisions = 0;
+    for (const auto& p : state.particles) {
+        wallHits += p.wallHits;
+        collisions += p.collisions;
+    }
+    std::cout << "Finished at step " << state.step << " in " << seconds << " s: total wallHits=" << wallHits
+              << ", total collisions=" << collisions / 2 << std::endl;
+
+    if (!config.trajectoryPath.empty()) { // Read the trajectory back: last frame, without re-simulating
+        TrajectoryReader reader;
+        std::vector<float> xy;
+        if (reader.open(config.trajectoryPath, reason) && reader.particleCount() > 0) {
+            uint64_t step = state.step - state.step % reader.stepInterval(); // Last step a frame was due
+            if (reader.readStep(step, xy)) {
+                std::cout << "Trajectory " << config.trajectoryPath << ": " << reader.frameCount() << " frames, last at step " << step
+                          << ", particle 0 at (" << xy[0] << ", " << xy[1] << ")" << std::endl;
+            }
+        }
+    }
+}
+
+// Prints the verdict of a railway log validation.
+static void report_validation(bool correct, const std::string& reason, int record_number) {
+    if (correct) {
+        std::cout << "Railway Simulation is correct." << std::endl;
+    }
+    else {
+        std::cout << "Error in Railway Simulation." << std::endl << reason << " record_index=" << record_number << std::endl;
+    }
+}
+
+// Writes events to config.eventLogPath (if set) and validates the file by streaming it back.
+static void write_and_check_event_log(const ParticleSimConfig& config, const RailwayNetwork& network, const std::vector<RailEvent>& events) {
+    if (config.eventLogPath.empty()) return;
+    std::string reason;
+    EventLogWriter writer;
+    if (!writer.open(config.eventLogPath, static_cast<uint32_t>(network.trainCount()), static_cast<uint32_t>(network.sectionCount()),
+                     network.trainsExpectedToEnter(config.numSteps), reason)) {
+        std::cerr << reason << std::endl;
+        return;
+    }
+    writer.write(events.data(), events.size());
+    writer.close();
+    std::cout << "  event log: " << config.eventLogPath << " (" << events.size() * sizeof(RailEvent) << " bytes of records)" << std::endl;
+    run_event_log_validation(config);
+}
+
+void run_network_simulation(const ParticleSimConfig& config) {
+    std::unique_ptr<RailwayNetwork> network = config.numTrains == 0
+        ? RailwayNetwork::classic()
+        : RailwayNetwork::generated(config.numTrains, config.numSections, config.routeLength, config.sectionsPerRoute, config.seed);
+
+    std::cout << "Railway network: " << network->trainCount() << " trains, " << network->sectionCount() << " shared sections, "
+              << config.numSteps << " steps per train, "
+              << (config.discreteEvent ? "discrete-event" : std::string(track_lock_policy_name(config.trackLock)) + " sections") << std::endl;
+
+    std::string reason;
+    int record_number = 0;
+    std::vector<bool> expected = network->trainsExpectedToEnter(config.numSteps);
+
+    if (config.discreteEvent) {
+        auto t0 = std::chrono::steady_clock::now();
+        EventSimResult sim = simulate_discrete_events(*network, config.numSteps);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        double moves = static_cast<double>(network->trainCount()) * config.numSteps;
+
+        std::cout << "  discrete-event: " << sim.events.size() << " events, " << sim.processedEvents << " moves processed, "
+                  << sim.blockedWaits << " waits, virtual time " << sim.virtualTime / 1000.0 << " s" << std::endl;
+        std::cout << "  wall time: " << seconds * 1000.0 << " ms (" << moves / (seconds * 1000.0) << " simulated steps/ms)" << std::endl;
+
+        if (config.numTrains == 0) { // Classic layout: the trains_log strings go through the original validator
+            report_validation(isSimulationCorrect(to_trains_log(*network, sim.events), reason, record_number), reason, record_number);
+        }
+        else {
+            report_validation(isNetworkSimulationCorrect(*network, sim.events, expected, reason, record_number), reason, record_number);
+        }
+        write_and_check_event_log(config, *network, sim.events);
+        return;
+    }
+
+    network->setLockPolicy(config.trackLock);
+    auto t0 = std::chrono::steady_clock::now();
+    network->run(config.numSteps, std::chrono::milliseconds(config.stepMillis));
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    auto v0 = std::chrono::steady_clock::now();
+    bool correct = isNetworkSimulationCorrect(*network, network->events(), expected, reason, record_number);
+    double validateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - v0).count();
+    std::cout << "  events: " << network->events().size() << ", time: " << seconds << " s, validation: "
+              << validateSeconds * 1000.0 << " ms" << std::endl;
+
+    if (config.numThreads > 1) { // Parallel validation must reach the same verdict on the same record
+        WorkerPool pool(config.numThreads);
+        std::string parallelReason;
+        int parallelRecord = 0;
+        auto p0 = std::chrono::steady_clock::now();
+        bool parallelCorrect = isNetworkSimulationCorrect(*network, network->events(), expected, pool, parallelReason, parallelRecord);
+        double parallelSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - p0).count();
+        bool same = parallelCorrect == correct && parallelRecord == record_number && parallelReason == reason;
+        std::cout << "  parallel validation (" << config.numThreads << " threads): " << parallelSeconds * 1000.0 << " ms, "
+                  << (same ? "same result" : "DIFFERENT result: " + parallelReason + " record_index=" + std::to_string(parallelRecord))
+                  << std::endl;
+    }
+    report_validation(correct, reason, record_number);
+    write_and_check_event_log(config, *network, network->events());
+}
+
+void run_domain_simulation(const ParticleSimConfig& config) {
+    std::vector<Particle> particles(config.numParticles);
+    for (size_t i = 0; i < particles.size(); i++) particles[i] = Particle(static_cast<int>(i));
+    initialize_particles(particles); // Serial: no threads may exist when the workers are forked
+    std::cout << "Domain decomposition: " << particles.size() << " particles, " << config.numSteps << " steps, "
+              << config.domain.tilesX << "x" << config.domain.tilesY << " tiles (one process each), rings of "
+              << config.domain.ringCapacity << " particles" << std::endl;
+
+    DomainResult result;
+    std::string reason;
+    if (!run_domain_decomposition(particles, config.numSteps, config.dt, config.domain, result, reason)) {
+        std::cerr << "Domain decomposition failed: " << reason << std::endl;
+        return;
+    }
+    for (size_t t = 0; t < result.tiles.size(); t++) {
+        const TileReport& r = result.tiles[t];
+        std::cout << "  tile " << t << " (" << t % config.domain.tilesX << ", " << t / config.domain.tilesX << "): " << r.particles
+                  << " particles, " << r.wallHits << " wall hits, " << r.migratedOut << " out, " << r.migratedIn << " in, "
+                  << r.ringFullWaits << " waits on a full ring" << std::endl;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int step = 0; step < config.numSteps; step++) update_particles(particles, config.dt, 0, particles.size());
+    double singleSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    bool same = true;
+    long long singleHits = 0;
+    for (const Particle& p : particles) {
+        same = same && result.wallHitsById[p.id] == p.wallHits;
+        singleHits += p.wallHits;
+    }
+    std::cout << "  total wall hits: " << result.wallHits << " (single process: " << singleHits << ", per particle "
+              << (same ? "identical" : "DIFFERENT") << ")" << std::endl;
+    std::cout << "  time: " << result.seconds * 1000.0 << " ms with " << result.tiles.size() << " processes, "
+              << singleSeconds * 1000.0 << " ms in one thread" << std::endl;
+}
+
+void run_event_log_validation(const ParticleSimConfig& config) {
+    std::string reason;
+    int record_number = 0;
+    uint64_t records = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    bool correct = validate_event_log_file(config.eventLogPath, reason, record_number, records);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "Event log " << config.eventLogPath << ": " << records << " records checked in " << seconds * 1000.0 << " ms ("
+              << (seconds > 0 ? records / seconds / 1e6 : 0.0) << " M records/s)" << std::endl;
+    report_validation(correct, reason, record_number);
+}
+
+void run_render_benchmark(const ParticleSimConfig& config) {
+    std::vector<Particle> particles(config.numParticles);
+    for (size_t i = 0; i < particles.size(); i++) particles[i] = Particle(static_cast<int>(i));
+    initialize_particles(particles);
+
+    FrameRenderer renderer(config.width, config.height);
+    const char* bufferBefore = renderer.compose(particles, true).data(); // Warm-up frame
+    size_t bytes = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < config.numSteps; frame++) {
+        update_particles(particles, config.dt, 0, particles.size());
+        renderer.compose(particles, true);
+        bytes += renderer.frameSize();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    bool reallocated = renderer.compose(particles, true).data() != bufferBefore;
+
+    std::cout << "Render benchmark (" << config.width << "x" << config.height << " grid, " << config.numParticles
+              << " particles, " << config.numSteps << " frames)\n";
+    std::cout << "  frames/s:          " << config.numSteps / seconds << std::endl;
+    std::cout << "  avg frame size:    " << bytes / config.numSteps << " bytes" << std::endl;
+    std::cout << "  buffer reallocated: " << (reallocated ? "yes" : "no") << std::endl;
+}
+
+void run_pipeline_benchmark(const ParticleSimConfig& config) {
+    std::vector<Particle> initial(config.numParticles);
+    for (size_t i = 0; i < initial.size(); i++) initial[i] = Particle(static_cast<int>(i));
+    initialize_particles(initial);
+    WorkerPool pool(config.numThreads);
+
+    // Baseline: compute, stats and frame composition one after the other for every step
+    std::vector<Particle> particles = initial;
+    SpatialGrid grid(2 * config.collisionRadius);
+    FrameRenderer renderer(config.width, config.height);
+    FrameStats stats;
+    double busy[3] = { 0, 0, 0 };
+    auto t0 = std::chrono::steady_clock::now();
+    for (int step = 0; step < config.numSteps; step++) {
+        auto t1 = std::chrono::steady_clock::now();
+        pool.runStep(particles.size(), [&](size_t start, size_t end) {
+            update_particles(particles, config.dt, start, end);
+        });
+        if (config.collisionRadius > 0) collide_particles(particles, config.collisionRadius, grid, pool);
+        auto t2 = std::chrono::steady_clock::now();
+        compute_frame_stats(particles, stats);
+        auto t3 = std::chrono::steady_clock::now();
+        renderer.compose(particles, true);
+        auto t4 = std::chrono::steady_clock::now();
+        busy[0] += std::chrono::duration<double>(t2 - t1).count();
+        busy[1] += std::chrono::duration<double>(t3 - t2).count();
+        busy[2] += std::chrono::duration<double>(t4 - t3).count();
+    }
+    double serialSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    PipelineOptions options;
+    options.depth = config.pipelineDepth;
+    options.draw = false; // Compose only, so the terminal does not set the pace
+    options.width = config.width;
+    options.height = config.height;
+    PipelineResult piped = run_particle_pipeline(initial, config.numSteps, config.dt, config.collisionRadius, pool, options);
+
+    std::cout << "Pipeline benchmark (" << config.numParticles << " particles, " << config.numSteps << " frames, "
+              << config.numThreads << " compute threads, depth " << options.depth << ", "
+              << std::thread::hardware_concurrency() << " hardware threads)\n";
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "  stage busy ms        compute    stats   render\n";
+    std::cout << "  serial           " << std::setw(10) << busy[0] * 1000.0 << std::setw(9) << busy[1] * 1000.0
+              << std::setw(9) << busy[2] * 1000.0 << "\n";
+    std::cout << "  pipelined        " << std::setw(10) << piped.stageBusySeconds[0] * 1000.0 << std::setw(9)
+              << piped.stageBusySeconds[1] * 1000.0 << std::setw(9) << piped.stageBusySeconds[2] * 1000.0 << "\n";
+    std::cout << std::setprecision(1);
+    std::cout << "  frames/s: serial " << config.numSteps / serialSeconds << ", pipelined " << piped.frames / piped.seconds
+              << " (" << std::setprecision(2) << serialSeconds / piped.seconds << "x)\n";
+    std::cout << "  backpressure waits: " << piped.backpressureWaits << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << "  total wall hits: serial " << stats.wallHits << ", pipelined " << piped.lastStats.wallHits
+              << (stats.wallHits == piped.lastStats.wallHits ? " (match)" : " (MISMATCH)") << std::endl;
+}
+
+// Synthetic per-item cost, in work units, of the skewed workloads of run_stealing_benchmark().
+static std::vector<uint32_t> skewed_costs(const std::string& profile, size_t count) {
+    std::vector<uint32_t> costs(count, 1);
+    std::mt19937 gen(12345);
+    for (size_t i = 0; i < count; i++) {
+        if (profile == "ramp") costs[i] = 1 + static_cast<uint32_t>(64 * i / count); // Later items cost more
+        else if (profile == "hot block") costs[i] = i < count / 8 ? 32 : 1; // A crowded region at the start
+        else if (profile == "heavy tail") costs[i] = gen() % 64 == 0 ? 256 : 1; // Rare, very expensive items
+    }
+    return costs;
+}
+
+// One work unit: a short dependent chain the compiler cannot remove.
+static float burn(uint32_t units, float x) {
+    for (uint32_t u = 0; u < units * 64; u++) x = x * 0.999999f + 0.5f;
+    return x;
+}
+
+void run_stealing_benchmark(const ParticleSimConfig& config) {
+    const size_t count = config.numParticles;
+    std::vector<size_t> threadCounts;
+    for (size_t t = 1; t < config.numThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(config.numThreads);
+
+    std::cout << "Work-stealing benchmark (" << count << " items, " << config.numSteps << " steps, "
+              << std::thread::hardware_concurrency() << " hardware threads)\n";
+    std::cout << "imbalance = most work units run by one worker / mean per worker (1.00 = perfect)\n";
+    std::cout << std::setw(12) << "workload" << std::setw(9) << "threads" << std::setw(12) << "static ms" << std::setw(12) << "steal ms"
+              << std::setw(11) << "speedup" << std::setw(12) << "imb static" << std::setw(11) << "imb steal" << std::setw(9) << "steals" << std::endl;
+
+    std::vector<float> out(count);
+    for (const char* profile : { "uniform", "ramp", "hot block", "heavy tail" }) {
+        std::vector<uint32_t> costs = skewed_costs(profile, count);
+        for (size_t threads : threadCounts) {
+            WorkerPool pool(threads);
+            std::vector<uint64_t> units(threads);
+            auto task = [&](size_t worker, size_t start, size_t end) {
+                uint64_t done = 0;
+                for (size_t i = start; i < end; i++) {
+                    out[i] = burn(costs[i], static_cast<float>(i));
+                    done += costs[i];
+                }
+                units[worker] += done;
+            };
+            auto imbalance = [&] {
+                uint64_t most = 0, total = 0;
+                for (uint64_t u : units) {
+                    most = std::max(most, u);
+                    total += u;
+                }
+                return total > 0 ? static_cast<double>(most) * threads / total : 1.0;
+            };
+
+            auto t0 = std::chrono::steady_clock::now();
+            for (int step = 0; step < config.numSteps; step++) pool.runIndexedStep(count, task);
+            double staticSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            double staticImbalance = imbalance();
+
+            std::fill(units.begin(), units.end(), 0);
+            uint64_t stealsBefore = pool.stealCount();
+            t0 = std::chrono::steady_clock::now();
+            for (int step = 0; step < config.numSteps; step++) pool.runStealingStep(count, task);
+            double stealSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+            std::cout << std::setw(12) << profile << std::setw(9) << threads << std::fixed << std::setprecision(2)
+                      << std::setw(12) << staticSeconds * 1000.0 << std::setw(12) << stealSeconds * 1000.0
+                      << std::setw(10) << staticSeconds / stealSeconds << "x" << std::setw(12) << staticImbalance
+                      << std::setw(11) << imbalance() << std::setw(9) << (pool.stealCount() - stealsBefore) / config.numSteps << std::endl;
+            std::cout.unsetf(std::ios::fixed);
+        }
+    }
+}
+
+void run_alignment_benchmark(const ParticleSimConfig& config) {
+    std::vector<size_t> threadCounts;
+    for (size_t t = 1; t < config.numThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(config.numThreads);
+
+    std::cout << "False-sharing benchmark (" << config.numParticles << " particles of " << sizeof(Particle) << " bytes, "
+              << config.numSteps << " steps, " << std::thread::hardware_concurrency() << " hardware threads)\n";
+    std::cout << "packed:  partition_range ranges, wall-hit totals in adjacent array slots\n";
+    std::cout << "aligned: ranges on cache-line boundaries, totals in PerWorker slots\n";
+    std::cout << std::setw(8) << "threads" << std::setw(16) << "packed ns/p/s" << std::setw(17) << "aligned ns/p/s"
+              << std::setw(10) << "speedup" << std::setw(12) << "wallHits" << std::endl;
+
+    std::vector<Particle> initial(config.numParticles);
+    for (size_t i = 0; i < initial.size(); i++) initial[i] = Particle(static_cast<int>(i));
+    initialize_particles(initial);
+    const double particleSteps = static_cast<double>(config.numParticles) * config.numSteps;
+
+    for (size_t threads : threadCounts) {
+        WorkerPool pool(threads);
+        long long packedTotal = 0, alignedTotal = 0;
+
+        std::vector<Particle> particles = initial;
+        std::vector<long long> packed(threads, 0); // Neighbouring workers' totals share a line
+        auto t0 = std::chrono::steady_clock::now();
+        for (int step = 0; step < config.numSteps; step++) {
+            pool.runIndexedStep(particles.size(), [&](size_t worker, size_t start, size_t end) {
+                for (size_t i = start; i < end; i++) packed[worker] += update_particles_counted(particles, config.dt, i, i + 1);
+            });
+        }
+        double packedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        for (long long hits : packed) packedTotal += hits; // Reduced once here; the per-step totals are the same
+
+        particles = initial;
+        std::vector<PerWorker<long long>> aligned(threads);
+        t0 = std::chrono::steady_clock::now();
+        for (int step = 0; step < config.numSteps; step++) {
+            pool.runAlignedStep(particles, [&](size_t worker, size_t start, size_t end) {
+                for (size_t i = start; i < end; i++) aligned[worker].value += update_particles_counted(particles, config.dt, i, i + 1);
+            });
+        }
+        double alignedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        for (const auto& hits : aligned) alignedTotal += hits.value;
+
+        long long particleHits = 0;
+        for (const Particle& p : particles) particleHits += p.wallHits;
+        bool agree = packedTotal == alignedTotal && alignedTotal == particleHits;
+
+        std::cout << std::setw(8) << threads << std::fixed << std::setprecision(3) << std::setw(16) << packedSeconds * 1e9 / particleSteps
+                  << std::setw(17) << alignedSeconds * 1e9 / particleSteps << std::setw(9) << std::setprecision(2)
+                  << packedSeconds / alignedSeconds << "x" << std::setw(12) << alignedTotal << (agree ? "" : "  MISMATCH") << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+    }
+}
+
+void run_init_benchmark(const ParticleSimConfig& config) {
+    const size_t n = config.numParticles;
+    WorkerPool pool(config.numThreads);
+    std::vector<Particle> serial(n), parallel(n), philox(n);
+    for (size_t i = 0; i < n; i++) serial[i] = parallel[i] = philox[i] = Particle(static_cast<int>(i));
+
+    auto t0 = std::chrono::steady_clock::now();
+    initialize_particles(serial);
+    auto t1 = std::chrono::steady_clock::now();
+    initialize_particles_parallel(parallel, pool, ParticleRng::Mt19937);
+    auto t2 = std::chrono::steady_clock::now();
+    initialize_particles_parallel(philox, pool, ParticleRng::Philox);
+    auto t3 = std::chrono::steady_clock::now();
+
+    ParticleSoA serialSoa, parallelSoa; // The SoA fills, checked the same way
+    auto t4 = std::chrono::steady_clock::now();
+    initialize_particles_soa(serialSoa, n);
+    auto t5 = std::chrono::steady_clock::now();
+    initialize_particles_soa_parallel(parallelSoa, n, pool, ParticleRng::Mt19937);
+    auto t6 = std::chrono::steady_clock::now();
+
+    bool identical = true;
+    for (size_t i = 0; i < n && identical; i++) {
+        identical = serial[i].x == parallel[i].x && serial[i].y == parallel[i].y && serial[i].vx == parallel[i].vx && serial[i].vy == parallel[i].vy;
+    }
+    bool identicalSoa = serialSoa.x == parallelSoa.x && serialSoa.y == parallelSoa.y && serialSoa.vx == parallelSoa.vx
+        && serialSoa.vy == parallelSoa.vy && serialSoa.id == parallelSoa.id;
+    auto rate = [n](std::chrono::steady_clock::duration d) {
+        double seconds = std::chrono::duration<double>(d).count();
+        return seconds > 0 ? n / seconds / 1e6 : 0.0;
+    };
+    std::cout << "Initialisation benchmark (" << n << " particles, " << config.numThreads << " threads, "
+              << std::thread::hardware_concurrency() << " hardware threads)\n";
+    std::cout << "  serial mt19937:    " << rate(t1 - t0) << " M particles/s\n";
+    std::cout << "  parallel mt19937:  " << rate(t2 - t1) << " M particles/s, " << (identical ? "identical to serial" : "DIFFERENT from serial") << "\n";
+    std::cout << "  parallel philox:   " << rate(t3 - t2) << " M particles/s\n";
+    std::cout << "  serial SoA:        " << rate(t5 - t4) << " M particles/s\n";
+    std::cout << "  parallel SoA:      " << rate(t6 - t5) << " M particles/s, " << (identicalSoa ? "identical to serial" : "DIFFERENT from serial") << std::endl;
+}
+
+void run_fastforward_benchmark(const ParticleSimConfig& config) {
+    const size_t n = config.numParticles;
+    const uint64_t steps = static_cast<uint64_t>(config.numSteps);
+    WorkerPool pool(config.numThreads);
+    std::vector<Particle> start(n);
+    for (size_t i = 0; i < n; i++) start[i] = Particle(static_cast<int>(i));
+    initialize_particles_parallel(start, pool);
+
+    std::vector<Particle> stepped = start, forwarded = start;
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint64_t step = 0; step < steps; step++) {
+        pool.runStep(n, [&](size_t s, size_t e) { update_particles(stepped, config.dt, s, e); });
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    uint64_t work = fast_forward_particles(forwarded, config.dt, steps, pool);
+    auto t2 = std::chrono::steady_clock::now();
+
+    bool identical = true;
+    long long wallHits = 0;
+    for (size_t i = 0; i < n; i++) {
+        const Particle& a = stepped[i];
+        const Particle& b = forwarded[i];
+        identical = identical && a.x == b.x && a.y == b.y && a.vx == b.vx && a.vy == b.vy && a.wallHits == b.wallHits;
+        wallHits += a.wallHits;
+    }
+    auto ms = [](std::chrono::steady_clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+    std::cout << "Fast-forward benchmark (" << n << " particles, " << steps << " steps, dt " << config.dt << ", "
+              << config.numThreads << " threads)\n";
+    std::cout << "  fixed steps:   " << ms(t1 - t0) << " ms, " << steps * n << " particle updates, " << wallHits << " wall hits\n";
+    std::cout << "  fast-forward:  " << ms(t2 - t1) << " ms, " << work << " jumps and single steps, "
+              << (identical ? "identical to fixed steps" : "DIFFERENT from fixed steps") << "\n";
+
+    // The same simulated time in finer steps: fixed steps get dearer with every step, while the
+    // fast-forward work follows the wall hits and binades crossed (fixed steps extrapolated)
+    for (uint64_t factor = 10; factor <= 1000; factor *= 10) {
+        std::vector<Particle> fine = start;
+        float fineDt = config.dt / factor;
+        auto t3 = std::chrono::steady_clock::now();
+        uint64_t fineWork = fast_forward_particles(fine, fineDt, steps * factor, pool);
+        auto t4 = std::chrono::steady_clock::now();
+        long long fineHits = 0;
+        for (const Particle& p : fine) fineHits += p.wallHits;
+        std::cout << "  dt / " << std::setw(4) << factor << ":    " << ms(t4 - t3) << " ms (fixed steps ~" << ms(t1 - t0) * factor << " ms), "
+                  << fineWork << " jumps and single steps for " << fineHits << " wall hits (" << std::fixed << std::setprecision(1)
+                  << (fineHits > 0 ? static_cast<double>(fineWork) / fineHits : 0.0) << " per hit)" << std::defaultfloat << std::setprecision(6) << "\n";
+    }
+    std::cout << std::flush;
+}
+
+// Hardware cache misses of the calling thread and the threads it starts afterwards, counted by
+// the kernel (Linux perf_event_open). available() is false on other systems and where the kernel
+// or a container does not allow it. Read the count after the started threads have exited.
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+#ifdef __linux__
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.exclude_kernel = 1;
+        attr.inherit = 1; // Include the pool's workers
+        fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+    ~CacheMissCounter() {
+#ifdef __linux__
+        if (fd >= 0) close(fd);
+#endif
+    }
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+    bool available() const { return fd >= 0; }
+    uint64_t read() const {
+        uint64_t count = 0;
+#ifdef __linux__
+        if (fd >= 0 && ::read(fd, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count))) count = 0;
+#endif
+        return count;
+    }
+
+private:
+    int fd = -1; // Counter file descriptor (-1 = not available)
+};
+
+// Misses per particle of a 32 KB direct-mapped cache model replaying the particle reads of the
+// collision narrow phase (each particle, then its candidates in the 3x3 neighbouring cells).
+// Unlike hardware counters it is available everywhere and free of noise from other work.
+static double modelled_misses_per_particle(const std::vector<Particle>& particles, const SpatialGrid& grid) {
+    const size_t MODEL_LINES = 32 * 1024 / CACHE_LINE_BYTES;
+    std::vector<size_t> tags(MODEL_LINES, SIZE_MAX);
+    size_t misses = 0;
+    auto touch = [&](size_t index) {
+        size_t line = index * sizeof(Particle) / CACHE_LINE_BYTES;
+        size_t& tag = tags[line % MODEL_LINES];
+        if (tag != line) {
+            tag = line;
+            misses++;
+        }
+    };
+    const int side = grid.cellsPerSide();
+    for (size_t i = 0; i < particles.size(); i++) {
+        touch(i);
+        int cx = grid.cellCoord(particles[i].x);
+        int cy = grid.cellCoord(particles[i].y);
+        for (int ny = std::max(cy - 1, 0); ny <= std::min(cy + 1, side - 1); ny++) {
+            for (int nx = std::max(cx - 1, 0); nx <= std::min(cx + 1, side - 1); nx++) {
+                size_t cell = static_cast<size_t>(ny) * side + nx;
+                for (uint32_t k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; k++) touch(grid.cellParticles[k]);
+            }
+        }
+    }
+    return particles.empty() ? 0.0 : static_cast<double>(misses) / particles.size();
+}
+
+// Timings of one bench-morton run, in milliseconds over all steps.
+struct MortonRunResult {
+    double updateMs = 0, collideMs = 0, renderMs = 0, reorderMs = 0;
+    double modelledMisses = 0; // Mean of modelled_misses_per_particle over the steps
+    long long collisions = 0;
+    bool missesAvailable = false;
+    uint64_t cacheMisses = 0;
+    std::vector<int> wallHitsById; // Final wallHits, indexed by particle id
+};
+
+static MortonRunResult run_morton_once(const ParticleSimConfig& config, float radius, int reorderEvery) {
+    MortonRunResult result;
+    CacheMissCounter misses; // Opened before the pool, so its workers are counted too
+    {
+        WorkerPool pool(config.numThreads);
+        std::vector<Particle> particles(config.numParticles);
+        for (size_t i = 0; i < particles.size(); i++) particles[i] = Particle(static_cast<int>(i));
+        initialize_particles_parallel(particles, pool, config.rng);
+        SpatialGrid grid(2 * radius);
+        FrameRenderer renderer(config.width, config.height);
+        MortonReorder reorder;
+
+        using Clock = std::chrono::steady_clock;
+        auto ms = [](Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); };
+        for (int step = 0; step < config.numSteps; step++) {
+            auto t0 = Clock::now();
+            if (reorderEvery > 0 && step % reorderEvery == 0) reorder.reorder(particles, pool);
+            auto t1 = Clock::now();
+            pool.runStep(particles.size(), [&](size_t start, size_t end) { update_particles(particles, config.dt, start, end); });
+            auto t2 = Clock::now();
+            result.collisions += collide_particles(particles, radius, grid, pool);
+            auto t3 = Clock::now();
+            renderer.compose(particles, false);
+            auto t4 = Clock::now();
+            result.reorderMs += ms(t1 - t0);
+            result.updateMs += ms(t2 - t1);
+            result.collideMs += ms(t3 - t2);
+            result.renderMs += ms(t4 - t3);
+            result.modelledMisses += modelled_misses_per_particle(particles, grid); // Outside the timed phases
+        }
+        result.modelledMisses /= config.numSteps;
+
+        reorder.restoreIdOrder(particles, pool);
+        for (const Particle& p : particles) result.wallHitsById.push_back(p.wallHits);
+    }
+    result.missesAvailable = misses.available();
+    result.cacheMisses = misses.read();
+    return result;
+}
+
+void run_morton_benchmark(const ParticleSimConfig& config) {
+    const float radius = config.collisionRadius > 0 ? config.collisionRadius : 0.01f; // Neighbour queries need a radius
+    const int every = config.reorderEvery > 0 ? config.reorderEvery : 10;
+    std::cout << "Morton order benchmark (" << config.numParticles << " particles, " << config.numSteps << " steps, radius " << radius
+              << ", " << config.width << "x" << config.height << " frame, " << config.numThreads << " threads)\n";
+
+    MortonRunResult plain = run_morton_once(config, radius, 0);
+    MortonRunResult sorted = run_morton_once(config, radius, every);
+
+    auto print = [&config](const char* name, const MortonRunResult& r) {
+        double steps = config.numSteps;
+        std::cout << "  " << name << std::fixed << std::setprecision(3) << "update " << r.updateMs / steps << " ms, collisions "
+                  << r.collideMs / steps << " ms, render " << r.renderMs / steps << " ms, reorder " << r.reorderMs / steps
+                  << " ms = " << (r.updateMs + r.collideMs + r.renderMs + r.reorderMs) / steps << " ms/step\n"
+                  << "      " << std::setprecision(2) << r.modelledMisses << " modelled misses per particle (32 KB cache, narrow phase), hardware cache misses: ";
+        if (r.missesAvailable) std::cout << r.cacheMisses;
+        else std::cout << "not available";
+        std::cout << ", " << r.collisions << " collisions\n";
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+    };
+    print("random order:      ", plain);
+    print(("Morton every " + std::to_string(every) + ":  ").c_str(), sorted);
+    if (plain.modelledMisses > 0) {
+        std::cout << "  modelled misses: " << std::fixed << std::setprecision(1) << 100.0 * (1.0 - sorted.modelledMisses / plain.modelledMisses)
+                  << "% fewer with Morton order\n";
+    }
+    if (plain.missesAvailable && sorted.missesAvailable && plain.cacheMisses > 0) {
+        std::cout << "  cache misses: " << std::fixed << std::setprecision(1)
+                  << 100.0 * (1.0 - static_cast<double>(sorted.cacheMisses) / plain.cacheMisses) << "% fewer with Morton order\n";
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+    }
+    // Collisions are resolved in storage order, so only runs without any can be expected to match
+    bool same = plain.wallHitsById == sorted.wallHitsById;
+    std::cout << "  wall hits per id: " << (same ? "identical" : (plain.collisions + sorted.collisions > 0 ? "differ (collision order follows storage)" : "DIFFERENT"))
+              << std::endl;
+}
+
+void run_kernels_benchmark(const ParticleSimConfig& config) {
+    WorkerPool pool(config.numThreads);
+    std::cout << "Template kernel benchmark (" << config.numParticles << " particles, " << config.numSteps << " steps, dt " << config.dt << ", "
+              << config.numThreads << " threads)\n";
+
+    // Reference: the Particle simulation from the same start
+    std::vector<Particle> reference(config.numParticles);
+    for (size_t i = 0; i < reference.size(); i++) reference[i] = Particle(static_cast<int>(i));
+    initialize_particles_parallel(reference, pool, config.rng);
+    for (int step = 0; step < config.numSteps; step++) {
+        pool.runStep(reference.size(), [&](size_t start, size_t end) { update_particles(reference, config.dt, start, end); });
+    }
+
+    std::cout << std::setw(5) << "dim" << std::setw(8) << "scalar" << std::setw(10) << "boundary" << std::setw(18) << "ns/particle/step"
+              << std::setw(14) << "wallHits" << std::endl;
+    for (int dim = 2; dim <= 3; dim++) {
+        for (int precision = 0; precision < 2; precision++) {
+            for (BoundaryPolicy boundary : { BoundaryPolicy::Reflect, BoundaryPolicy::Wrap, BoundaryPolicy::Absorb }) {
+                KernelChoice choice;
+                choice.dim = dim;
+                choice.doublePrecision = precision == 1;
+                choice.boundary = boundary;
+                GenericRunResult r = run_generic_particles(choice, config.numParticles, config.numSteps, config.dt, pool, config.rng);
+                double ns = r.seconds * 1e9 / (static_cast<double>(config.numParticles) * config.numSteps);
+                std::cout << std::setw(5) << dim << std::setw(8) << (choice.doublePrecision ? "double" : "float") << std::setw(10)
+                          << boundary_policy_name(boundary) << std::setw(18) << std::fixed << std::setprecision(3) << ns << std::setw(14) << r.wallHits;
+                std::cout.unsetf(std::ios::floatfield);
+                std::cout << std::setprecision(6);
+                if (dim == 2 && !choice.doublePrecision && boundary == BoundaryPolicy::Reflect) {
+                    bool same = true;
+                    for (const Particle& p : reference) same = same && r.wallHitsById[p.id] == p.wallHits;
+                    std::cout << (same ? "  (same as Particle::update)" : "  (DIFFERENT from Particle::update!)");
+                }
+                std::cout << std::endl;
+            }
+        }
+    }
+}
+
+// Wait times of one train in the track lock benchmark.
+struct TrainWaits {
+    LatencyHistogram wait; // ns from asking for the section until getting in
+    float sink = 0; // Keeps the work in and out of the section from being optimised away
+};
+
+void run_track_lock_benchmark(const ParticleSimConfig& config) {
+    const size_t trains = config.numTrains > 0 ? static_cast<size_t>(config.numTrains) : 8;
+    const int traversals = config.numSteps;
+    std::cout << "Track lock benchmark (" << trains << " trains, " << traversals << " section traversals each, "
+              << std::thread::hardware_concurrency() << " hardware threads)\n";
+    std::cout << "wait in us; mean/train = smallest..largest mean wait of one train (a wide spread = starvation)\n";
+    std::cout << std::setw(10) << "policy" << std::setw(4) << "k" << std::setw(10) << "ms" << std::setw(12) << "trav/ms"
+              << std::setw(10) << "p50" << std::setw(10) << "p99" << std::setw(11) << "max" << std::setw(22) << "mean/train" << std::setw(8) << "inside" << std::endl;
+
+    struct Run { TrackLockPolicy policy; int k; };
+    std::vector<Run> runs = { { TrackLockPolicy::Mutex, 1 }, { TrackLockPolicy::Ticket, 1 }, { TrackLockPolicy::Mcs, 1 }, { TrackLockPolicy::Semaphore, 1 } };
+    if (config.occupancy > 1) runs.push_back({ TrackLockPolicy::Semaphore, config.occupancy });
+
+    for (const Run& run : runs) {
+        std::unique_ptr<TrackLock> lock = make_track_lock(run.policy, trains, run.k, "bench.track_lock");
+        std::vector<TrainWaits> waits(trains);
+        std::atomic<int> inside{ 0 }, mostInside{ 0 };
+        std::latch start(static_cast<std::ptrdiff_t>(trains) + 1);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < trains; t++) {
+            threads.emplace_back([&, t] {
+                TrainWaits& mine = waits[t];
+                start.arrive_and_wait();
+                for (int i = 0; i < traversals; i++) {
+                    uint64_t t0 = metrics_now_ns();
+                    lock->acquire(static_cast<uint32_t>(t));
+                    mine.wait.record(metrics_now_ns() - t0);
+                    int now = inside.fetch_add(1, std::memory_order_relaxed) + 1;
+                    for (int seen = mostInside.load(std::memory_order_relaxed); now > seen && !mostInside.compare_exchange_weak(seen, now, std::memory_order_relaxed);) {}
+                    mine.sink = burn(16, mine.sink); // On the section
+                    inside.fetch_sub(1, std::memory_order_relaxed);
+                    lock->release(static_cast<uint32_t>(t));
+                    mine.sink = burn(32, mine.sink); // Rest of the route
+                }
+            });
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        start.arrive_and_wait();
+        for (auto& thread : threads) thread.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        LatencyHistogram all;
+        double fewest = 1e300, most = 0;
+        for (const TrainWaits& w : waits) {
+            all.merge(w.wait);
+            double mean = static_cast<double>(w.wait.total()) / w.wait.count();
+            fewest = std::min(fewest, mean);
+            most = std::max(most, mean);
+        }
+        std::ostringstream spread;
+        spread << std::fixed << std::setprecision(1) << fewest / 1000.0 << ".." << most / 1000.0;
+        std::cout << std::setw(10) << track_lock_policy_name(run.policy) << std::setw(4) << run.k << std::fixed << std::setprecision(1)
+                  << std::setw(10) << seconds * 1000.0 << std::setw(12) << trains * traversals / (seconds * 1000.0)
+                  << std::setw(10) << all.percentile(50) / 1000.0 << std::setw(10) << all.percentile(99) / 1000.0
+                  << std::setw(11) << all.max() / 1000.0 << std::setw(22) << spread.str() << std::setw(8) << mostInside.load()
+                  << (mostInside.load() > run.k ? "  (MORE than k!)" : "") << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+        std::cout << std::setprecision(6);
+    }
+}
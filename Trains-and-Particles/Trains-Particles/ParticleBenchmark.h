@@ -0,0 +1,150 @@
+/**
+ * @file ParticleBenchmark.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef PARTICLE_BENCHMARK_H
+#define PARTICLE_BENCHMARK_H
+
+#include <string>
+#include "AsyncLogger.h"
+#include "ParticleRng.h"
+#include "ParticleKernels.h"
+#include "ParticleDomain.h"
+#include "Trains_and_Particles.h"
+
+// Run-time parameters of the particle simulation. The defaults are the compile-time
+// constants from Trains_and_Particles.h, so a run without options behaves as before.
+struct ParticleSimConfig {
+    std::string mode = "default"; // What main() should run: default, part2, run, network, headless, domain, bench-pool, bench-soa, bench-render, bench-pipeline, bench-steal, bench-align, bench-init, bench-fastforward, bench-morton, bench-kernels, bench-tracklock
+    size_t numParticles = NUM_PARTICLES; // Number of particles in the simulation
+    int numSteps = NUM_STEPS; // Total number of steps in the simulation
+    size_t numThreads = NUM_THREADS; // Largest number of threads used for parallel processing
+    float dt = DT; // Time step for each update in the simulation
+    std::string kernel = "soa"; // Update kernel for headless runs: "aos" (Particle::update), "soa" (SIMD) or "generic" (ParticleKernels.h)
+    KernelChoice kernelChoice; // headless generic: dimensions, scalar type and boundary policy
+    ParticleRng rng = ParticleRng::Mt19937; // headless: generator of the initial positions and velocities
+    bool alignedPartitions = false; // headless aos: worker ranges start on cache-line boundaries
+    int reorderEvery = 0; // headless aos, bench-morton: steps between Morton reorders of the particles (0 = never)
+    int width = WIDTH; // Width of the visualization grid (bench-render)
+    int height = HEIGHT; // Height of the visualization grid (bench-render)
+    DomainOptions domain; // domain: tiles (one worker process each) and ring buffer size
+    size_t pipelineDepth = 4; // Frames in flight between the pipeline stages (bench-pipeline)
+    float collisionRadius = COLLISION_RADIUS; // Particle radius for particle-particle collisions (0 disables them)
+    std::string checkpointPath; // run: checkpoint file written every checkpointEvery steps and at the end ("" = none)
+    int checkpointEvery = 0; // run: steps between checkpoints (0 = only at the end)
+    std::string resumePath; // run: checkpoint to resume from ("" = start from initialize_particles)
+    std::string trajectoryPath; // run: trajectory file ("" = none)
+    int trajectoryEvery = 1; // run: steps between trajectory frames
+    LoggerConfig logging; // Options of the asynchronous app.log logger
+    int numTrains = 0; // network: number of generated trains (0 = the classic two-train layout)
+    int numSections = 4; // network: number of shared sections
+    int routeLength = 25; // network: cells per generated route
+    int sectionsPerRoute = 3; // network: shared sections crossed by each generated route
+    unsigned seed = 12345; // network: seed of the route generator
+    int stepMillis = 0; // network: wall time per train move (RailwaySystem uses 1000)
+    TrackLockPolicy trackLock = TrackLockPolicy::Mutex; // default, network: guard of the shared track sections
+    int occupancy = 2; // bench-tracklock: trains the semaphore policy lets into the section at once
+    bool discreteEvent = false; // network: run on a virtual clock (RailwayEventSim) instead of threads
+    std::string metricsPath; // Any mode: instrumentation JSON written when the run ends ("" = metrics off)
+    std::string eventLogPath; // network: compact binary event log written after the run; validate-log: file to check
+};
+
+// Parses the command line into config. Prints a message and returns false on bad input.
+//   --part2 | --run | --network | --headless | --domain | --bench-pool | --bench-soa | --bench-render | --bench-pipeline | --bench-steal | --bench-align | --bench-init | --bench-fastforward | --bench-morton | --bench-kernels | --bench-tracklock     select the run mode
+//   --validate-log FILE     stream-validate a binary event log written with --event-log
+//   --metrics FILE     record timings (any mode) and write them as JSON at the end
+//   --particles N  --steps S  --threads T  --dt DT  --kernel aos|soa|generic  --dim 2|3  --scalar float|double  --boundary reflect|wrap|absorb  --radius R  --width W  --height H  --depth D  --aligned  --reorder K  --rng mt19937|philox
+//   --tiles AxB  --ring-capacity N
+//   --checkpoint FILE  --checkpoint-every K  --resume FILE  --trajectory FILE  --trajectory-every K
+//   --log-overflow drop|block  --log-flush-ms MS  --log-capacity N
+//   --trains N  --sections M  --route-length L  --sections-per-route K  --seed S  --step-ms MS  --des  --event-log FILE
+//   --track-lock mutex|ticket|mcs|semaphore  --occupancy K
+bool parse_command_line(int argc, char* argv[], ParticleSimConfig& config);
+
+// Prints the supported command line options.
+void print_usage(const char* program);
+
+// Headless benchmark: no rendering and no sleeping. Runs the configured simulation once per
+// thread count (1, 2, 4, ... up to config.numThreads) and prints ns/particle/step,
+// total wall hits (and collisions, with --radius) and the speedup/efficiency against one thread.
+void run_headless_benchmark(const ParticleSimConfig& config);
+
+// Single headless run on config.numThreads workers (AoS kernel, collisions with --radius) that
+// can resume from a checkpoint, write checkpoints and stream a trajectory. config.numSteps is
+// the total number of steps of the run, so a resumed run stops at the same step as an
+// uninterrupted one and ends in exactly the same state.
+void run_resumable_simulation(const ParticleSimConfig& config);
+
+// Runs a RailwayNetwork (generated with --trains, or the classic two-train layout) for
+// config.numSteps moves per train, then validates its log and prints the result and timing.
+// With --des the run is a discrete-event simulation on a virtual clock; the classic layout's
+// log is then also converted to trains_log strings and checked with isSimulationCorrect.
+// With --event-log the log is also written as 24-byte RailEvent records and validated again
+// by streaming the file back in fixed-size chunks.
+void run_network_simulation(const ParticleSimConfig& config);
+
+// Multi-process run: config.numParticles particles for config.numSteps steps split over
+// config.domain tiles (run_domain_decomposition). Prints what each tile's process reports and
+// checks the gathered wallHits, per particle, against a single-process run.
+void run_domain_simulation(const ParticleSimConfig& config);
+
+// Validates the event log file config.eventLogPath with StreamingTrainValidator, in constant memory.
+void run_event_log_validation(const ParticleSimConfig& config);
+
+// Renderer benchmark: composes config.numSteps frames of a width x height grid with the
+// allocation-free FrameRenderer (particles move between frames) and reports frames per second.
+// Output is not written to the terminal, so the number is the cost of building the frame.
+void run_render_benchmark(const ParticleSimConfig& config);
+
+// Pipeline benchmark: runs config.numSteps frames of compute, statistics and frame composition
+// one after the other, then as the three-stage pipeline of run_particle_pipeline(), and prints
+// frames per second, the busy time of each stage, backpressure waits and whether both runs
+// end with the same wall hits. Frames are composed but not written to the terminal.
+void run_pipeline_benchmark(const ParticleSimConfig& config);
+
+// Scheduler benchmark: config.numParticles items with uniform and skewed synthetic costs, run
+// config.numSteps times per thread count with the static split (runIndexedStep) and with work
+// stealing (runStealingStep). Prints the time of both, the load imbalance between workers and
+// the chunks stolen per step.
+void run_stealing_benchmark(const ParticleSimConfig& config);
+
+// False-sharing benchmark for the AoS update at 1, 2, 4, ... up to config.numThreads workers:
+// plain partition_range ranges with wall-hit totals in a packed per-worker array, against
+// cache-line-aligned ranges with PerWorker totals. Both reduce the totals at the end of each
+// step and must agree with the particles' own wallHits.
+void run_alignment_benchmark(const ParticleSimConfig& config);
+
+// Initialisation benchmark: config.numParticles particles filled by the serial initialize_particles,
+// by initialize_particles_parallel in mt19937 compatibility mode (checked to be identical) and
+// with Philox, on config.numThreads workers; then the same for the SoA store, with the serial
+// initialize_particles_soa as the reference. Prints particles per second for each.
+void run_init_benchmark(const ParticleSimConfig& config);
+
+// Fast-forward benchmark: config.numSteps fixed steps of the particles (no collisions) on the
+// pool against fast_forward_particles over the same steps, checked to be bit-for-bit identical,
+// then the same simulated time fast-forwarded with dt / 10, dt / 100 and dt / 1000 and the work
+// done per wall hit. Fast-forwarding pays off once a particle takes many steps between hits.
+void run_fastforward_benchmark(const ParticleSimConfig& config);
+
+// Spatial-order benchmark: config.numSteps steps of update, collisions (config.collisionRadius,
+// or a small radius when that is 0) and frame composition, once in the initial random order and
+// once Morton-reordered every config.reorderEvery steps (10 when 0). Prints the time per step of
+// each phase, the misses of a small cache model replaying the collision narrow phase, hardware
+// cache misses where the OS exposes them, and whether the wall hits per id came out the same.
+void run_morton_benchmark(const ParticleSimConfig& config);
+
+// Template kernel benchmark: every instantiation of run_generic_particles (2D and 3D, float and
+// double, reflect, wrap and absorb) for config.numSteps steps of config.numParticles particles,
+// with ns/particle/step and wall hits. Checks that 2D float reflect gives the same wall hits per
+// particle as the Particle (AoS) simulation.
+void run_kernels_benchmark(const ParticleSimConfig& config);
+
+// Shared-track contention benchmark: config.numTrains trains (8 when 0), each on its own thread,
+// take one shared section config.numSteps times with a short stay inside and a short run outside,
+// under every TrackLock policy (semaphore with k = 1 and k = config.occupancy). Prints section
+// throughput, the merged p50 / p99 / max wait, the spread of the mean wait per train (a wide
+// spread means some trains are starved) and the most trains seen inside at once.
+void run_track_lock_benchmark(const ParticleSimConfig& config);
+
+#endif // PARTICLE_BENCHMARK_H
@@ -0,0 +1,304 @@
+/**
+ * @file ParticleCheckpoint.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "ParticleCheckpoint.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+
+static const char CHECKPOINT_MAGIC[8] = { 'T', 'P', 'C', 'K', 'P', 'T', '0', '1' };
+static const char TRAJECTORY_MAGIC[8] = { 'T', 'P', 'T', 'R', 'A', 'J', '0', '1' };
+const size_t RECORD_SIZE = 4 * sizeof(float) + 3 * sizeof(int32_t); // One particle in a checkpoint
+const size_t RECORDS_PER_CHUNK = 65536; // Particles packed per write/read call
+const size_t TRAJECTORY_HEADER_SIZE = 8 + sizeof(uint64_t) + sizeof(uint32_t);
+
+// 64-bit FNV-1a, updated incrementally as the file is written or read.
+class Fnv1a {
+public:
+    void add(const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+    }
+    uint64_t value() const { return hash; }
+
+private:
+    uint64_t hash = 14695981039346656037ull;
+};
+
+// Writes raw bytes and adds them to the hash.
+static void put(std::ofstream& out, Fnv1a& hash, const void* data, size_t size) {
+    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    hash.add(data, size);
+}
+
+// Reads raw bytes and adds them to the hash; false at end of file.
+static bool get(std::ifstream& in, Fnv1a& hash, void* data, size_t size) {
+    if (!in.read(static_cast<char*>(data), static_cast<std::streamsize>(size))) return false;
+    hash.add(data, size);
+    return true;
+}
+
+bool save_checkpoint(const std::string& path, const ParticleCheckpoint& checkpoint, std::string& reason) {
+    const std::string tmpPath = path + ".tmp";
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        reason = "Cannot create checkpoint file " + tmpPath;
+        return false;
+    }
+
+    std::ostringstream genText;
+    genText << checkpoint.gen; // Standard, portable text form of the generator state
+    const std::string genState = genText.str();
+
+    Fnv1a hash;
+    uint64_t count = checkpoint.particles.size();
+    uint32_t genLength = static_cast<uint32_t>(genState.size());
+    put(out, hash, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    put(out, hash, &checkpoint.step, sizeof(checkpoint.step));
+    put(out, hash, &count, sizeof(count));
+    put(out, hash, &checkpoint.dt, sizeof(checkpoint.dt));
+    put(out, hash, &genLength, sizeof(genLength));
+    put(out, hash, genState.data(), genState.size());
+
+    std::vector<char> chunk(RECORDS_PER_CHUNK * RECORD_SIZE);
+    for (size_t first = 0; first < checkpoint.particles.size(); first += RECORDS_PER_CHUNK) {
+        size_t last = std::min(first + RECORDS_PER_CHUNK, checkpoint.particles.size());
+        char* rec = chunk.data();
+        for (size_t i = first; i < last; i++) { // Pack the fields; Particle itself may contain padding
+            const Particle& p = checkpoint.particles[i];
+            int32_t ints[3] = { p.id, p.wallHits, p.collisions };
+            std::memcpy(rec, &p.x, sizeof(float));
+            std::memcpy(rec + 4, &p.y, sizeof(float));
+            std::memcpy(rec + 8, &p.vx, sizeof(float));
+            std::memcpy(rec + 12, &p.vy, sizeof(float));
+            std::memcpy(rec + 16, ints, sizeof(ints));
+            rec += RECORD_SIZE;
+        }
+        put(out, hash, chunk.data(), (last - first) * RECORD_SIZE);
+    }
+
+    uint64_t checksum = hash.value();
+    out.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+    out.close();
+    if (!out) {
+        reason = "Error while writing checkpoint file " + tmpPath;
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec); // Replaces the previous checkpoint in one step
+    if (ec) {
+        reason = "Cannot rename " + tmpPath + " to " + path + ": " + ec.message();
+        return false;
+    }
+    return true;
+}
+
+bool load_checkpoint(const std::string& path, ParticleCheckpoint& checkpoint, std::string& reason) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        reason = "Cannot open checkpoint file " + path;
+        return false;
+    }
+
+    Fnv1a hash;
+    char magic[8];
+    uint64_t count = 0;
+    uint32_t genLength = 0;
+    if (!get(in, hash, magic, sizeof(magic)) || std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) != 0) {
+        reason = path + " is not a particle checkpoint";
+        return false;
+    }
+    if (!get(in, hash, &checkpoint.step, sizeof(checkpoint.step)) || !get(in, hash, &count, sizeof(count))
+        || !get(in, hash, &checkpoint.dt, sizeof(checkpoint.dt)) || !get(in, hash, &genLength, sizeof(genLength))) {
+        reason = "Checkpoint header is truncated";
+        return false;
+    }
+
+    // Check the lengths in the header against the file size before allocating for them: a corrupt
+    // header must fail with a reason, not with bad_alloc
+    std::error_code ec;
+    uint64_t fileSize = std::filesystem::file_size(path, ec);
+    uint64_t headerSize = sizeof(CHECKPOINT_MAGIC) + sizeof(checkpoint.step) + sizeof(count) + sizeof(checkpoint.dt) + sizeof(genLength) + uint64_t(genLength);
+    if (ec || fileSize < headerSize + sizeof(uint64_t)) {
+        reason = "Checkpoint generator state does not fit the file (file is corrupt or truncated)";
+        return false;
+    }
+
+    std::string genState(genLength, '\0');
+    if (!get(in, hash, &genState[0], genLength)) {
+        reason = "Checkpoint generator state is truncated";
+        return false;
+    }
+    std::istringstream genText(genState);
+    genText >> checkpoint.gen;
+    if (!genText) {
+        reason = "Checkpoint generator state is invalid";
+        return false;
+    }
+
+    if (count > (fileSize - headerSize - sizeof(uint64_t)) / RECORD_SIZE) {
+        reason = "Checkpoint particle count does not fit the file (file is corrupt or truncated)";
+        return false;
+    }
+    checkpoint.particles.assign(count, Particle());
+    std::vector<char> chunk(RECORDS_PER_CHUNK * RECORD_SIZE);
+    for (size_t first = 0; first < count; first += RECORDS_PER_CHUNK) {
+        size_t last = std::min<size_t>(first + RECORDS_PER_CHUNK, count);
+        if (!get(in, hash, chunk.data(), (last - first) * RECORD_SIZE)) {
+            reason = "Checkpoint particle data is truncated";
+            return false;
+        }
+        const char* rec = chunk.data();
+        for (size_t i = first; i < last; i++) {
+            Particle& p = checkpoint.particles[i];
+            int32_t ints[3];
+            std::memcpy(&p.x, rec, sizeof(float));
+            std::memcpy(&p.y, rec + 4, sizeof(float));
+            std::memcpy(&p.vx, rec + 8, sizeof(float));
+            std::memcpy(&p.vy, rec + 12, sizeof(float));
+            std::memcpy(ints, rec + 16, sizeof(ints));
+            p.id = ints[0];
+            p.wallHits = ints[1];
+            p.collisions = ints[2];
+            rec += RECORD_SIZE;
+        }
+    }
+
+    uint64_t checksum = 0;
+    if (!in.read(reinterpret_cast<char*>(&checksum), sizeof(checksum)) || checksum != hash.value()) {
+        reason = "Checkpoint checksum does not match (file is corrupt or truncated)";
+        return false;
+    }
+    return true;
+}
+
+// Reads and checks a trajectory header; false with reason if it is missing or not a trajectory.
+static bool read_trajectory_header(std::ifstream& in, const std::string& path, uint64_t& count, uint32_t& every, std::string& reason) {
+    char magic[8];
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    in.read(reinterpret_cast<char*>(&every), sizeof(every));
+    if (!in || std::memcmp(magic, TRAJECTORY_MAGIC, sizeof(magic)) != 0 || every == 0) {
+        reason = path + " is not a particle trajectory";
+        return false;
+    }
+    return true;
+}
+
+bool TrajectoryWriter::openStream(const std::string& path, size_t particles, uint32_t every, std::ios::openmode mode, std::string& reason) {
+    numParticles = particles;
+    everySteps = every == 0 ? 1 : every;
+    frame.resize(2 * numParticles);
+    streamBuffer.resize(1 << 20); // 1 MiB: frames go to the OS in large blocks
+    file.rdbuf()->pubsetbuf(streamBuffer.data(), static_cast<std::streamsize>(streamBuffer.size()));
+    file.open(path, std::ios::binary | mode);
+    if (!file) {
+        reason = "Cannot open trajectory file " + path;
+        return false;
+    }
+    return true;
+}
+
+bool TrajectoryWriter::open(const std::string& path, size_t particles, uint32_t every, std::string& reason) {
+    if (!openStream(path, particles, every, std::ios::trunc, reason)) return false;
+    uint64_t count = numParticles;
+    file.write(TRAJECTORY_MAGIC, sizeof(TRAJECTORY_MAGIC));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(&everySteps), sizeof(everySteps));
+    return true;
+}
+
+bool TrajectoryWriter::resume(const std::string& path, size_t particles, uint32_t every, uint64_t step, std::string& reason) {
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) return open(path, particles, every, reason);
+    every = every == 0 ? 1 : every;
+
+    uint64_t keep = 0; // Frames to keep: complete ones recorded at or before step
+    const uint64_t frameSize = sizeof(uint64_t) + 2 * sizeof(float) * particles;
+    {
+        std::ifstream in(path, std::ios::binary);
+        uint64_t count = 0;
+        uint32_t storedEvery = 0;
+        if (!read_trajectory_header(in, path, count, storedEvery, reason)) return false;
+        if (count != particles || storedEvery != every) {
+            reason = path + " holds " + std::to_string(count) + " particles every " + std::to_string(storedEvery)
+                + " steps, but the resumed run has " + std::to_string(particles) + " every " + std::to_string(every);
+            return false;
+        }
+        uint64_t complete = (std::filesystem::file_size(path) - TRAJECTORY_HEADER_SIZE) / frameSize;
+        for (; keep < complete; keep++) { // Frame steps increase, so stop at the first one past step
+            uint64_t frameStep = 0;
+            in.seekg(static_cast<std::streamoff>(TRAJECTORY_HEADER_SIZE + keep * frameSize));
+            if (!in.read(reinterpret_cast<char*>(&frameStep), sizeof(frameStep)) || frameStep > step) break;
+        }
+    }
+
+    std::filesystem::resize_file(path, TRAJECTORY_HEADER_SIZE + keep * frameSize, ec);
+    if (ec) {
+        reason = "Cannot truncate trajectory file " + path + ": " + ec.message();
+        return false;
+    }
+    return openStream(path, particles, every, std::ios::app, reason);
+}
+
+void TrajectoryWriter::record(uint64_t step, const std::vector<Particle>& particles) {
+    if (!file.is_open() || step % everySteps != 0) return;
+    for (size_t i = 0; i < numParticles; i++) {
+        frame[2 * i] = particles[i].x;
+        frame[2 * i + 1] = particles[i].y;
+    }
+    file.write(reinterpret_cast<const char*>(&step), sizeof(step));
+    file.write(reinterpret_cast<const char*>(frame.data()), static_cast<std::streamsize>(frame.size() * sizeof(float)));
+}
+
+void TrajectoryWriter::close() {
+    if (file.is_open()) file.close();
+}
+
+bool TrajectoryReader::open(const std::string& path, std::string& reason) {
+    file.open(path, std::ios::binary);
+    if (!file) {
+        reason = "Cannot open trajectory file " + path;
+        return false;
+    }
+    uint64_t count = 0;
+    if (!read_trajectory_header(file, path, count, everySteps, reason)) return false;
+    // Check the count against the file size before using it: a corrupt header must not wrap the
+    // frame size around (to zero or to something small) and make readFrame allocate for it
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(path, ec);
+    if (ec || size < TRAJECTORY_HEADER_SIZE || count > (size - TRAJECTORY_HEADER_SIZE) / (2 * sizeof(float))) {
+        reason = "Trajectory particle count does not fit the file (file is corrupt or truncated)";
+        return false;
+    }
+    numParticles = count;
+    uint64_t frameSize = sizeof(uint64_t) + 2 * sizeof(float) * numParticles;
+    frames = static_cast<size_t>((size - TRAJECTORY_HEADER_SIZE) / frameSize); // A partly written last frame is ignored
+    if (frames > 0 && !file.read(reinterpret_cast<char*>(&firstStep), sizeof(firstStep))) frames = 0;
+    return true;
+}
+
+bool TrajectoryReader::readFrame(size_t index, uint64_t& step, std::vector<float>& xy) {
+    if (index >= frames) return false;
+    uint64_t frameSize = sizeof(uint64_t) + 2 * sizeof(float) * numParticles;
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(TRAJECTORY_HEADER_SIZE + index * frameSize));
+    xy.resize(2 * numParticles);
+    file.read(reinterpret_cast<char*>(&step), sizeof(step));
+    file.read(reinterpret_cast<char*>(xy.data()), static_cast<std::streamsize>(xy.size() * sizeof(float)));
+    return static_cast<bool>(file);
+}
+
+bool TrajectoryReader::readStep(uint64_t step, std::vector<float>& xy) {
+    if (frames == 0 || step < firstStep || (step - firstStep) % everySteps != 0) return false;
+    uint64_t stored = 0;
+    return readFrame(static_cast<size_t>((step - firstStep) / everySteps), stored, xy) && stored == step;
+}
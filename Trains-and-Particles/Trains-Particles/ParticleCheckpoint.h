@@ -0,0 +1,83 @@
+/**
+ * @file ParticleCheckpoint.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef PARTICLE_CHECKPOINT_H
+#define PARTICLE_CHECKPOINT_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <random>
+#include <cstdint>
+#include "Trains_and_Particles.h"
+
+// Everything needed to resume a particle simulation exactly where it stopped.
+struct ParticleCheckpoint {
+    uint64_t step = 0; // Number of steps already simulated
+    float dt = DT; // Time step the run uses
+    std::vector<Particle> particles; // x, y, vx, vy, id, wallHits, collisions of every particle
+    std::mt19937 gen; // Generator state after initialize_particles (and any later draws)
+};
+
+// Checkpoint file layout (little-endian, as written on x86/x64):
+//   char[8]  magic "TPCKPT01"
+//   uint64   step, uint64 particle count, float dt, uint32 generator-state length
+//   char[]   generator state (the standard text form of std::mt19937)
+//   records  float x, y, vx, vy; int32 id, wallHits, collisions   (28 bytes each)
+//   uint64   FNV-1a hash of everything before it, to detect truncated or corrupt files
+// The file is written to "<path>.tmp" and renamed, so a crash never leaves a half-written checkpoint.
+// Both functions return false and set reason on failure.
+bool save_checkpoint(const std::string& path, const ParticleCheckpoint& checkpoint, std::string& reason);
+bool load_checkpoint(const std::string& path, ParticleCheckpoint& checkpoint, std::string& reason);
+
+// TrajectoryWriter streams particle positions to a binary file every K steps, through a large
+// write buffer so a frame costs one buffered copy and no per-particle system calls.
+// Layout: char[8] "TPTRAJ01", uint64 particle count, uint32 every-K; then fixed-size frames of
+// uint64 step followed by float x, y per particle. Frames are fixed size, so a reader can seek
+// straight to any of them.
+// resume() reopens the trajectory of an interrupted run: it checks the header against the resumed
+// run and cuts the file back to the frames at or before the checkpoint step, dropping frames written
+// after the checkpoint and any partly written last frame, so appended frames are never duplicated
+// or misaligned. A missing file is created as by open().
+class TrajectoryWriter {
+public:
+    TrajectoryWriter() : numParticles(0), everySteps(1) {}
+    ~TrajectoryWriter() { close(); } // Flushes while streamBuffer is still alive.
+    bool open(const std::string& path, size_t numParticles, uint32_t everySteps, std::string& reason); // Creates the file.
+    bool resume(const std::string& path, size_t numParticles, uint32_t everySteps, uint64_t step, std::string& reason); // Extends the file from step.
+    void record(uint64_t step, const std::vector<Particle>& particles); // Writes a frame if step is a multiple of every-K.
+    void close(); // Flushes and closes the file.
+    bool isOpen() const { return file.is_open(); }
+
+private:
+    bool openStream(const std::string& path, size_t particles, uint32_t every, std::ios::openmode mode, std::string& reason);
+
+    std::vector<char> streamBuffer; // Buffer handed to the stream so frames are written in large blocks (declared first: outlives file)
+    std::ofstream file; // Trajectory file
+    std::vector<float> frame; // Reused frame of x, y pairs
+    size_t numParticles; // Particles per frame
+    uint32_t everySteps; // Frame interval K
+};
+
+// TrajectoryReader gives random access to the frames of a trajectory file. Frames are every-K
+// steps apart from the step of the first frame, so readStep() can seek straight to a step.
+class TrajectoryReader {
+public:
+    bool open(const std::string& path, std::string& reason); // Reads and checks the header.
+    size_t frameCount() const { return frames; } // Number of complete frames in the file.
+    size_t particleCount() const { return numParticles; }
+    uint32_t stepInterval() const { return everySteps; } // Steps between frames (every-K).
+    bool readFrame(size_t index, uint64_t& step, std::vector<float>& xy); // Reads frame index (x, y pairs).
+    bool readStep(uint64_t step, std::vector<float>& xy); // Reads the frame recorded at step, if there is one.
+
+private:
+    std::ifstream file; // Trajectory file
+    size_t numParticles = 0; // Particles per frame
+    uint32_t everySteps = 1; // Steps between frames
+    uint64_t firstStep = 0; // Step of frame 0
+    size_t frames = 0; // Complete frames available
+};
+
+#endif // PARTICLE_CHECKPOINT_H
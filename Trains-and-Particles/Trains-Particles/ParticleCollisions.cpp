@@ -0,0 +1,138 @@
+/**
+ * @file ParticleCollisions.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "ParticleCollisions.h"
+#include <algorithm>
+#include "Instrumentation.h"
+
+const float BOX_MIN = -10.0f; // Lower wall of the simulation box
+const float BOX_SIZE = 20.0f; // Distance between opposite walls
+const int MAX_CELLS_PER_SIDE = 1024; // Caps histogram memory for very small radii; larger cells stay correct
+
+SpatialGrid::SpatialGrid(float cellSize) {
+    side = 1;
+    if (cellSize > 0) { // Round down so cells are never smaller than cellSize
+        side = static_cast<int>(std::min(BOX_SIZE / cellSize, static_cast<float>(MAX_CELLS_PER_SIDE)));
+        side = std::max(side, 1);
+    }
+    invCellSize = side / BOX_SIZE;
+    cellStart.assign(static_cast<size_t>(side) * side + 1, 0);
+}
+
+// Particles may sit slightly outside the box for one step before they are reflected, so clamp.
+int SpatialGrid::cellCoord(float v) const {
+    int c = static_cast<int>((v - BOX_MIN) * invCellSize);
+    return std::min(std::max(c, 0), side - 1);
+}
+
+void SpatialGrid::build(const std::vector<Particle>& particles, WorkerPool& pool) {
+    const size_t numCells = static_cast<size_t>(side) * side;
+    const size_t numWorkers = pool.size();
+    particleCell.resize(particles.size());
+    cellParticles.resize(particles.size());
+    workerCounts.resize(numWorkers);
+    for (auto& counts : workerCounts) counts.clear(); // Workers with an empty range leave theirs empty
+
+    // Pass 1 (parallel): cell of every particle and a histogram per worker
+    pool.runIndexedStep(particles.size(), [&](size_t worker, size_t start, size_t end) {
+        std::vector<uint32_t>& counts = workerCounts[worker];
+        counts.assign(numCells, 0);
+        for (size_t i = start; i < end; i++) {
+            uint32_t cell = static_cast<uint32_t>(cellCoord(particles[i].y) * side + cellCoord(particles[i].x));
+            particleCell[i] = cell;
+            counts[cell]++;
+        }
+    });
+
+    // Pass 2 (serial): exclusive prefix sum, cell-major then worker-minor, so that every
+    // worker's counters become its first write position inside each cell
+    uint32_t offset = 0;
+    for (size_t c = 0; c < numCells; c++) {
+        cellStart[c] = offset;
+        for (size_t w = 0; w < numWorkers; w++) {
+            if (workerCounts[w].empty()) continue; // Worker had an empty range
+            uint32_t n = workerCounts[w][c];
+            workerCounts[w][c] = offset;
+            offset += n;
+        }
+    }
+    cellStart[numCells] = offset;
+
+    // Pass 3 (parallel): scatter; workers own disjoint slots, and order inside a cell stays by index
+    pool.runIndexedStep(particles.size(), [&](size_t worker, size_t start, size_t end) {
+        std::vector<uint32_t>& next = workerCounts[worker];
+        for (size_t i = start; i < end; i++) {
+            cellParticles[next[particleCell[i]]++] = static_cast<uint32_t>(i);
+        }
+    });
+}
+
+// Equal-mass elastic collision of a and b if they are approaching; false if they are coincident
+// or already separating (an overlap that was resolved before is not counted again).
+static bool resolve_pair(Particle& a, Particle& b) {
+    float dx = b.x - a.x;
+    float dy = b.y - a.y;
+    float dist2 = dx * dx + dy * dy;
+    float approach = (b.vx - a.vx) * dx + (b.vy - a.vy) * dy;
+    if (dist2 == 0.0f || approach >= 0.0f) return false;
+    float k = approach / dist2; // Exchange the velocity components along the line of centres
+    a.vx += k * dx;
+    a.vy += k * dy;
+    b.vx -= k * dx;
+    b.vy -= k * dy;
+    a.collisions++;
+    b.collisions++;
+    return true;
+}
+
+size_t collide_particles(std::vector<Particle>& particles, float radius, SpatialGrid& grid, WorkerPool& pool) {
+    TP_SCOPED_TIMER("particles.collisions");
+    grid.build(particles, pool); // Broad phase
+
+    const float minDist2 = (2 * radius) * (2 * radius); // Two particles touch below this squared distance
+    const int side = grid.cellsPerSide();
+    std::vector<PerWorker<size_t>> workerCollisions(pool.size());
+
+    // Narrow phase and resolution, one colour at a time. A pair is handled by the cell of its
+    // lower-index particle and only touches that cell's 3x3 neighbourhood; cells of one colour
+    // (cx % 3, cy % 3) are at least three apart, so their neighbourhoods share no particle and
+    // the cells of a colour can run on any worker in any order. Positions do not change here,
+    // only velocities, so the grid stays valid throughout.
+    for (int colour = 0; colour < 9; colour++) {
+        const int ox = colour % 3, oy = colour / 3;
+        const size_t cols = side > ox ? static_cast<size_t>(side - ox + 2) / 3 : 0;
+        const size_t rows = side > oy ? static_cast<size_t>(side - oy + 2) / 3 : 0;
+        if (cols * rows == 0) continue;
+        // Crowded cells cost far more than empty ones, so the cells are work-stolen
+        pool.runStealingStep(cols * rows, [&](size_t worker, size_t start, size_t end) {
+            size_t& collisions = workerCollisions[worker].value;
+            for (size_t c = start; c < end; c++) {
+                const int cx = ox + 3 * static_cast<int>(c % cols);
+                const int cy = oy + 3 * static_cast<int>(c / cols);
+                const size_t home = static_cast<size_t>(cy) * side + cx;
+                for (uint32_t h = grid.cellStart[home]; h < grid.cellStart[home + 1]; h++) {
+                    const uint32_t i = grid.cellParticles[h]; // Increasing index within the cell
+                    for (int ny = std::max(cy - 1, 0); ny <= std::min(cy + 1, side - 1); ny++) {
+                        for (int nx = std::max(cx - 1, 0); nx <= std::min(cx + 1, side - 1); nx++) {
+                            size_t cell = static_cast<size_t>(ny) * side + nx;
+                            for (uint32_t k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; k++) {
+                                uint32_t j = grid.cellParticles[k];
+                                if (j <= i) continue; // Each pair is found once, by its lower index
+                                float dx = particles[j].x - particles[i].x;
+                                float dy = particles[j].y - particles[i].y;
+                                if (dx * dx + dy * dy < minDist2 && resolve_pair(particles[i], particles[j])) collisions++;
+                            }
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    size_t collisions = 0;
+    for (const auto& wc : workerCollisions) collisions += wc.value;
+    return collisions;
+}
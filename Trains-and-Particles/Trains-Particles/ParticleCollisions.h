@@ -0,0 +1,47 @@
+/**
+ * @file ParticleCollisions.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef PARTICLE_COLLISIONS_H
+#define PARTICLE_COLLISIONS_H
+
+#include <vector>
+#include <cstdint>
+#include "Trains_and_Particles.h"
+#include "WorkerPool.h"
+
+// SpatialGrid is a uniform grid over the [-10, 10] box used as the broad phase for
+// particle-particle collisions. The box is bounded, so the "hash" of a position is simply
+// its dense cell index. build() is a parallel counting sort: afterwards the particles of
+// cell c are cellParticles[cellStart[c] .. cellStart[c + 1]), in increasing particle index.
+class SpatialGrid {
+public:
+    explicit SpatialGrid(float cellSize); // Constructor: Cells of at least cellSize on each side.
+
+    void build(const std::vector<Particle>& particles, WorkerPool& pool); // Rebuilds the grid from the current positions.
+    int cellCoord(float v) const; // Column/row of a coordinate, clamped to the grid.
+    int cellsPerSide() const { return side; } // Number of cells along each axis.
+
+    std::vector<uint32_t> cellStart; // Offset of each cell in cellParticles (size = cells + 1).
+    std::vector<uint32_t> cellParticles; // Particle indices sorted by cell.
+
+private:
+    int side; // Cells along each axis
+    float invCellSize; // 1 / actual cell size
+    std::vector<uint32_t> particleCell; // Cell of each particle, computed once per build
+    std::vector<std::vector<uint32_t>> workerCounts; // Per-worker histograms, turned into scatter offsets
+};
+
+// Detects and resolves collisions between particles of the given radius.
+// Broad phase: grid.build(). Narrow phase and resolution run together in nine passes, one per
+// colour (cx % 3, cy % 3) of the grid cells: within a pass, cells are work-stolen across the
+// pool, and each cell checks its particles against the 3x3 neighbouring cells and resolves
+// every touching pair (i < j) at once as an equal-mass elastic collision. Cells of one colour
+// never share a particle, and the colours and the pairs within a cell always come in the same
+// order, so the result does not depend on the number of threads. Overlapping pairs that are
+// already moving apart are not counted again. Each collision adds one to both particles'
+// collisions counter. Returns the number of collisions resolved in this step.
+size_t collide_particles(std::vector<Particle>& particles, float radius, SpatialGrid& grid, WorkerPool& pool);
+
+#endif // PARTICLE_COLLISIONS_H
@@ -0,0 +1,277 @@
+/**
+ * @file ParticleDomain.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "ParticleDomain.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#ifdef __linux__
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+
+// Atomics in shared memory are only shared between processes when they are lock-free.
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "rings need lock-free 64-bit atomics");
+static_assert(std::is_trivially_copyable<Particle>::value, "particles are copied through shared memory");
+
+const size_t SHM_ALIGN = 64; // Every region of the segment starts on its own cache line
+
+static size_t round_up(size_t bytes) {
+    return (bytes + SHM_ALIGN - 1) / SHM_ALIGN * SHM_ALIGN;
+}
+
+// Start of the segment: what every process needs to run the steps together.
+struct DomainControl {
+    pthread_barrier_t stepBarrier; // Process-shared; nobody pushes while a tile is still draining
+    alignas(SHM_ALIGN) std::atomic<uint64_t> donePushing; // Workers finished pushing, summed over all steps
+};
+
+// Single-producer/single-consumer ring of particles; the slots follow the header.
+struct ParticleRing {
+    alignas(SHM_ALIGN) std::atomic<uint64_t> head; // Next slot to read (consumer)
+    alignas(SHM_ALIGN) std::atomic<uint64_t> tail; // Next slot to write (producer)
+
+    Particle* slots() { return reinterpret_cast<Particle*>(this + 1); }
+
+    bool push(const Particle& p, size_t capacity) {
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == capacity) return false;
+        slots()[t % capacity] = p;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    bool pop(Particle& p, size_t capacity) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        p = slots()[h % capacity];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// Offsets of the regions of the segment and pointers into the mapping.
+class DomainSegment {
+public:
+    DomainSegment(size_t numParticles, int numTiles, size_t ringCapacity)
+        : numParticles(numParticles), numTiles(numTiles), ringCapacity(ringCapacity) {
+        tilesOffset = round_up(sizeof(DomainControl));
+        hitsOffset = tilesOffset + round_up(sizeof(TileReport) * numTiles);
+        initialOffset = hitsOffset + round_up(sizeof(int) * numParticles);
+        ringsOffset = initialOffset + round_up(sizeof(Particle) * numParticles);
+        ringBytes = round_up(sizeof(ParticleRing) + sizeof(Particle) * ringCapacity);
+        bytes = ringsOffset + ringBytes * numTiles * numTiles;
+    }
+
+    void attach(void* mapping) { base = static_cast<char*>(mapping); }
+
+    DomainControl& control() { return *reinterpret_cast<DomainControl*>(base); }
+    TileReport& tile(int t) { return reinterpret_cast<TileReport*>(base + tilesOffset)[t]; }
+    int* finalHits() { return reinterpret_cast<int*>(base + hitsOffset); }
+    Particle* initial() { return reinterpret_cast<Particle*>(base + initialOffset); }
+    ParticleRing& ring(int from, int to) { return *reinterpret_cast<ParticleRing*>(base + ringsOffset + ringBytes * (static_cast<size_t>(from) * numTiles + to)); }
+
+    const size_t numParticles;
+    const int numTiles;
+    const size_t ringCapacity;
+    size_t bytes; // Size of the whole segment
+
+private:
+    char* base = nullptr;
+    size_t tilesOffset, hitsOffset, initialOffset, ringsOffset, ringBytes;
+};
+
+// Tile owning a position; positions just outside the box (before the reflection) clamp.
+static int tile_of(const Particle& p, const DomainOptions& options) {
+    int tx = static_cast<int>((p.x + 10.0f) / 20.0f * options.tilesX);
+    int ty = static_cast<int>((p.y + 10.0f) / 20.0f * options.tilesY);
+    tx = std::min(std::max(tx, 0), options.tilesX - 1);
+    ty = std::min(std::max(ty, 0), options.tilesY - 1);
+    return ty * options.tilesX + tx;
+}
+
+// Moves everything waiting in this tile's incoming rings into arrivals.
+static void drain_incoming(DomainSegment& shm, int me, std::vector<Particle>& arrivals) {
+    Particle p;
+    for (int from = 0; from < shm.numTiles; from++) {
+        if (from == me) continue;
+        ParticleRing& ring = shm.ring(from, me);
+        while (ring.pop(p, shm.ringCapacity)) arrivals.push_back(p);
+    }
+}
+
+// Body of one worker process. Uses no stdio and no threads: it runs in a forked child.
+static void run_tile(DomainSegment& shm, int me, int numSteps, float dt, const DomainOptions& options) {
+    TileReport report;
+    std::vector<Particle> mine, arrivals;
+    for (size_t i = 0; i < shm.numParticles; i++) {
+        if (tile_of(shm.initial()[i], options) == me) mine.push_back(shm.initial()[i]);
+    }
+
+    const uint64_t numTiles = static_cast<uint64_t>(shm.numTiles);
+    for (int step = 0; step < numSteps; step++) {
+        size_t kept = 0;
+        for (size_t i = 0; i < mine.size(); i++) {
+            Particle p = mine[i];
+            p.update(dt);
+            int owner = tile_of(p, options);
+            if (owner == me) {
+                mine[kept++] = p;
+                continue;
+            }
+            while (!shm.ring(me, owner).push(p, shm.ringCapacity)) { // Full: let the owner catch up
+                report.ringFullWaits++;
+                drain_incoming(shm, me, arrivals);
+                sched_yield();
+            }
+            report.migratedOut++;
+        }
+        mine.resize(kept);
+
+        // Everything sent this step is in the rings once all tiles have finished pushing
+        shm.control().donePushing.fetch_add(1, std::memory_order_acq_rel);
+        while (shm.control().donePushing.load(std::memory_order_acquire) < numTiles * (step + 1)) {
+            drain_incoming(shm, me, arrivals);
+            sched_yield();
+        }
+        drain_incoming(shm, me, arrivals);
+        report.migratedIn += arrivals.size();
+        mine.insert(mine.end(), arrivals.begin(), arrivals.end());
+        arrivals.clear();
+        pthread_barrier_wait(&shm.control().stepBarrier);
+    }
+
+    report.particles = mine.size();
+    for (const Particle& p : mine) {
+        report.wallHits += p.wallHits;
+        shm.finalHits()[p.id] = p.wallHits;
+    }
+    shm.tile(me) = report;
+}
+
+bool run_domain_decomposition(const std::vector<Particle>& initial, int numSteps, float dt, const DomainOptions& options,
+                              DomainResult& result, std::string& reason) {
+    if (options.tilesX <= 0 || options.tilesY <= 0 || options.ringCapacity == 0) {
+        reason = "tiles and ring capacity must be greater than zero";
+        return false;
+    }
+    const int numTiles = options.tilesX * options.tilesY;
+    DomainSegment shm(initial.size(), numTiles, options.ringCapacity);
+
+    // The name is only needed until the mapping exists: unlinked at once, the segment goes away
+    // with the last process, however the run ends
+    std::string name = "/tp_domain_" + std::to_string(getpid());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        reason = "shm_open " + name + ": " + std::strerror(errno);
+        return false;
+    }
+    shm_unlink(name.c_str());
+    if (ftruncate(fd, static_cast<off_t>(shm.bytes)) != 0) {
+        reason = std::string("ftruncate: ") + std::strerror(errno);
+        close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, shm.bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        reason = std::string("mmap: ") + std::strerror(errno);
+        return false;
+    }
+    shm.attach(mapping); // Fresh pages are zero: every ring starts empty
+
+    pthread_barrierattr_t attr;
+    pthread_barrierattr_init(&attr);
+    pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_barrier_init(&shm.control().stepBarrier, &attr, static_cast<unsigned>(numTiles));
+    pthread_barrierattr_destroy(&attr);
+    new (&shm.control().donePushing) std::atomic<uint64_t>(0);
+    for (int from = 0; from < numTiles; from++) {
+        for (int to = 0; to < numTiles; to++) {
+            new (&shm.ring(from, to).head) std::atomic<uint64_t>(0);
+            new (&shm.ring(from, to).tail) std::atomic<uint64_t>(0);
+        }
+    }
+    std::copy(initial.begin(), initial.end(), shm.initial());
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<pid_t> workers;
+    bool ok = true;
+    for (int t = 0; t < numTiles && ok; t++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            run_tile(shm, t, numSteps, dt, options);
+            _exit(0); // Skip the parent's atexit handlers and destructors
+        }
+        if (pid < 0) {
+            reason = std::string("fork: ") + std::strerror(errno);
+            ok = false;
+        }
+        else workers.push_back(pid);
+    }
+    // Reap in exit order: once one worker dies the others wait for it for ever (at the barrier or
+    // for donePushing), so the rest are killed at once instead of being waited for. Only workers
+    // not yet reaped are signalled; a reaped pid may already belong to another process.
+    if (!ok) { // The started workers would wait at the barrier for ever
+        for (pid_t pid : workers) kill(pid, SIGKILL);
+    }
+    while (!workers.empty()) {
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            if (ok) reason = std::string("waitpid: ") + std::strerror(errno);
+            ok = false;
+            break;
+        }
+        auto reaped = std::find(workers.begin(), workers.end(), pid);
+        if (reaped == workers.end()) continue; // Not one of ours
+        workers.erase(reaped);
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0) continue;
+        if (ok) {
+            reason = "worker process " + std::to_string(pid) + (WIFSIGNALED(status)
+                ? " was killed by signal " + std::to_string(WTERMSIG(status))
+                : " exited with status " + std::to_string(WEXITSTATUS(status)));
+            for (pid_t other : workers) kill(other, SIGKILL);
+        }
+        ok = false;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    if (ok) { // Gather
+        result.tiles.assign(numTiles, TileReport());
+        result.wallHits = 0;
+        for (int t = 0; t < numTiles; t++) {
+            result.tiles[t] = shm.tile(t);
+            result.wallHits += static_cast<long long>(result.tiles[t].wallHits);
+        }
+        result.wallHitsById.assign(shm.finalHits(), shm.finalHits() + initial.size());
+    }
+    if (ok) { // glibc's destroy waits for waiters to leave the barrier, and a killed worker never does
+        pthread_barrier_destroy(&shm.control().stepBarrier);
+    }
+    munmap(mapping, shm.bytes);
+    return ok;
+}
+
+#else
+
+bool run_domain_decomposition(const std::vector<Particle>&, int, float, const DomainOptions&, DomainResult&, std::string& reason) {
+    reason = "the multi-process domain decomposition needs Linux (fork, POSIX shared memory)";
+    return false;
+}
+
+#endif // __linux__
@@ -0,0 +1,57 @@
+/**
+ * @file ParticleDomain.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef PARTICLE_DOMAIN_H
+#define PARTICLE_DOMAIN_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "Trains_and_Particles.h"
+
+// Domain decomposition over processes: the [-10, 10]^2 box is cut into tilesX x tilesY tiles,
+// and each tile is simulated by its own worker process holding only the particles inside it.
+// Processes share nothing but one POSIX shared-memory segment:
+//   - a process-shared barrier that separates the steps,
+//   - one single-producer/single-consumer ring buffer per ordered pair of tiles, through which a
+//     particle that crossed a tile edge migrates to the tile that now owns it,
+//   - a summary slot per tile and a wallHits slot per particle id, gathered by the coordinator
+//     (the calling process) once the workers have exited.
+// Each step a worker updates its particles, pushes the leavers into the rings, and drains its
+// incoming rings until every worker has finished pushing; a worker waiting on a full ring drains
+// its own rings meanwhile, so small rings only slow the exchange down. The same layout maps onto
+// multi-node runs with the rings replaced by messages between neighbours.
+//
+// Linux (and other POSIX systems with fork and shm_open) only; elsewhere
+// run_domain_decomposition() returns false with a reason.
+
+struct DomainOptions {
+    int tilesX = 2, tilesY = 2; // Tiles along x and y; one worker process each
+    size_t ringCapacity = 1024; // Particles per ring buffer (one ring per ordered pair of tiles)
+};
+
+// What one tile's worker reports at the end of the run.
+struct TileReport {
+    uint64_t particles = 0; // Particles owned at the end
+    uint64_t wallHits = 0; // Sum of their wallHits
+    uint64_t migratedOut = 0; // Particles sent to other tiles over the run
+    uint64_t migratedIn = 0; // Particles received from other tiles
+    uint64_t ringFullWaits = 0; // Times a push found the ring full and had to wait
+};
+
+struct DomainResult {
+    std::vector<TileReport> tiles; // Indexed by tile (row-major, y then x)
+    long long wallHits = 0; // Total over all tiles, as gathered by the coordinator
+    std::vector<int> wallHitsById; // Final wallHits of each particle (ids are 0..n-1)
+    double seconds = 0; // Wall time from starting the workers until the last one exited
+};
+
+// Simulates initial (ids 0..n-1) for numSteps steps of dt with Particle::update, split over
+// worker processes. Returns false and sets reason if the platform or the system calls fail, or
+// a worker does not exit cleanly.
+bool run_domain_decomposition(const std::vector<Particle>& initial, int numSteps, float dt, const DomainOptions& options,
+                              DomainResult& result, std::string& reason);
+
+#endif // PARTICLE_DOMAIN_H
@@ -0,0 +1,96 @@
+/**
+ * @file ParticleFastForward.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "ParticleFastForward.h"
+#include "WorkerPool.h"
+#include <cmath>
+
+const int FLOAT_MANTISSA_BITS = 24; // Significand bits of a float, including the implicit one
+const float WALL = 10.0f; // Particle::update reflects at x <= -10 and x >= 10
+
+// Nearest integer to q, or false on a tie (the rounding would depend on the last bit of pos).
+static bool round_increment(double q, long long& s) {
+    if (q - std::floor(q) == 0.5) return false;
+    s = std::llround(q);
+    return true;
+}
+
+// Largest number of steps (at most limit) that pos can take with increment vel * dt without
+// leaving its binade or reaching a wall, and moves pos there. While |pos| stays in
+// [2^(e-1), 2^e) all values are multiples of u = 2^(e-24), so each step rounds to the same
+// integer number of u. The compiler may contract pos += vel * dt into a fused multiply-add
+// (GCC and Clang do with FMA enabled, MSVC does not by default), so the increment must be the
+// same whether or not vel * dt is rounded first. Returns 0 when that cannot be guaranteed (zero
+// or denormal pos, a rounding tie, or no room before the binade edge), and the caller then takes
+// one real step. A particle whose increment rounds to nothing never moves again: all of limit.
+static uint64_t jump_in_binade(float& pos, float vel, float dt, uint64_t limit) {
+    if (limit == 0 || !std::isnormal(pos)) return 0;
+    int e;
+    std::frexp(std::fabs(pos), &e); // |pos| in [2^(e-1), 2^e)
+    const double u = std::ldexp(1.0, e - FLOAT_MANTISSA_BITS); // Spacing of floats in this binade
+    const float rounded = vel * dt;
+    const double exact = static_cast<double>(vel) * dt; // Exact: 48 significant bits at most
+    long long s, fused;
+    if (!round_increment(rounded / u, s) || !round_increment(exact / u, fused) || s != fused) return 0; // Divisions by u are exact
+
+    // |pos| / u stays in [low, high): low + 1 keeps the exact sum above 2^(e-1) as well, where
+    // the spacing halves; high is the top of the binade or the wall, whichever comes first
+    const long long low = (1LL << (FLOAT_MANTISSA_BITS - 1)) + 1;
+    long long high = 1LL << FLOAT_MANTISSA_BITS;
+    if (std::ldexp(1.0, e) > WALL) high = static_cast<long long>(WALL / u);
+    long long m = static_cast<long long>(std::fabs(pos) / u); // Exact integer
+    if (m >= high || m < low) return 0; // On or past a wall, or at the bottom edge
+    if (s == 0) return limit; // pos + d == pos for ever
+    long long step = pos > 0 ? s : -s; // Increment of |pos|
+
+    long long room = step > 0 ? (high - 1 - m) / step : (m - low) / -step;
+    if (room <= 0) return 0;
+    uint64_t j = static_cast<uint64_t>(room) < limit ? static_cast<uint64_t>(room) : limit;
+    m += static_cast<long long>(j) * step;
+    pos = static_cast<float>(std::copysign(static_cast<double>(m) * u, pos)); // Exact: m < 2^24
+    return j;
+}
+
+// Moves one axis forward by steps, reflecting at the walls exactly like Particle::update.
+// Returns the work done (jumps + single steps).
+static uint64_t fast_forward_axis(float& pos, float& vel, int& wallHits, float dt, uint64_t steps) {
+    uint64_t work = 0;
+    while (steps > 0) {
+        uint64_t j = jump_in_binade(pos, vel, dt, steps);
+        work++;
+        if (j > 0) {
+            steps -= j;
+            continue;
+        }
+        // One real step through Particle::update itself, so it rounds (and contracts) exactly as
+        // the fixed-step path; the other axis stays at 0 and never hits a wall
+        Particle single;
+        single.x = pos;
+        single.vx = vel;
+        single.update(dt);
+        pos = single.x;
+        vel = single.vx;
+        wallHits += single.wallHits;
+        steps--;
+    }
+    return work;
+}
+
+uint64_t fast_forward_particle(Particle& particle, float dt, uint64_t steps) {
+    // The axes never influence each other, so each can run to the end on its own
+    return fast_forward_axis(particle.x, particle.vx, particle.wallHits, dt, steps)
+         + fast_forward_axis(particle.y, particle.vy, particle.wallHits, dt, steps);
+}
+
+uint64_t fast_forward_particles(std::vector<Particle>& particles, float dt, uint64_t steps, WorkerPool& pool) {
+    std::vector<PerWorker<uint64_t>> work(pool.size());
+    pool.runStealingStep(particles.size(), [&](size_t worker, size_t start, size_t end) { // Slow and fast particles differ a lot
+        for (size_t i = start; i < end; i++) work[worker].value += fast_forward_particle(particles[i], dt, steps);
+    });
+    uint64_t total = 0;
+    for (const auto& w : work) total += w.value;
+    return total;
+}
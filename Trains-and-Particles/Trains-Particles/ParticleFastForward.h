@@ -0,0 +1,35 @@
+/**
+ * @file ParticleFastForward.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef PARTICLE_FAST_FORWARD_H
+#define PARTICLE_FAST_FORWARD_H
+
+#include <vector>
+#include <cstdint>
+#include "Trains_and_Particles.h"
+
+class WorkerPool;
+
+// Event-driven replacement for running update_particles() steps times (no particle-particle
+// collisions). Between two wall hits a particle only does x += vx * dt, and while x stays inside
+// one binade (a power-of-two range of |x|) every float addition rounds the same way, so a whole
+// run of steps collapses into one integer multiply. Each particle therefore jumps from binade
+// to binade and from wall hit to wall hit; a step is only simulated one at a time next to a
+// wall, on a rounding tie, or near zero. Positions, velocities and wallHits come out bit-for-bit
+// equal to the fixed-step path, and a run costs about (wall hits + binades crossed) per particle
+// instead of steps per particle.
+//
+// Particles do not interact, so each particle's events are processed in its own time order and
+// no global event queue is needed; this also lets the particles be split across the workers.
+
+// Advances one particle by steps fixed steps of dt. Returns the number of jumps and single
+// steps it took (the work done).
+uint64_t fast_forward_particle(Particle& particle, float dt, uint64_t steps);
+
+// Advances every particle by steps fixed steps of dt on the pool's workers.
+// Returns the total work, as fast_forward_particle().
+uint64_t fast_forward_particles(std::vector<Particle>& particles, float dt, uint64_t steps, WorkerPool& pool);
+
+#endif // PARTICLE_FAST_FORWARD_H
@@ -0,0 +1,92 @@
+/**
+ * @file ParticleKernels.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "ParticleKernels.h"
+#include "WorkerPool.h"
+#include "Instrumentation.h"
+#include <chrono>
+
+const uint64_t Z_KEY_SALT = 0x5A5A5A5A5A5A5A5Aull; // Keeps the z draws independent of a Philox x/y fill
+
+bool parse_boundary_policy(const std::string& name, BoundaryPolicy& policy) {
+    if (name == "reflect") policy = BoundaryPolicy::Reflect;
+    else if (name == "wrap") policy = BoundaryPolicy::Wrap;
+    else if (name == "absorb") policy = BoundaryPolicy::Absorb;
+    else return false;
+    return true;
+}
+
+const char* boundary_policy_name(BoundaryPolicy policy) {
+    switch (policy) {
+    case BoundaryPolicy::Wrap: return WrapBoundary::name();
+    case BoundaryPolicy::Absorb: return AbsorbBoundary::name();
+    default: return ReflectBoundary::name();
+    }
+}
+
+// Value in [-10, 10) from one 32-bit word (as the Philox fill in ParticleRng.cpp).
+static float z_coordinate(uint32_t word) {
+    return static_cast<float>(-10.0 + 20.0 * (word * (1.0 / 4294967296.0)));
+}
+
+// The whole run for one instantiation: the update loop below is compiled with Boundary, Dim
+// and Scalar fixed.
+template <typename Boundary, int Dim, typename Scalar>
+static GenericRunResult run_instance(size_t n, int numSteps, Scalar dt, WorkerPool& pool, ParticleRng rng, uint64_t seed) {
+    std::vector<Particle> planar(n);
+    initialize_particles_parallel(planar, pool, rng, seed);
+    std::vector<ParticleT<Dim, Scalar>> particles(n);
+    pool.runStep(n, [&](size_t start, size_t end) {
+        for (size_t i = start; i < end; i++) {
+            ParticleT<Dim, Scalar>& p = particles[i];
+            p.id = static_cast<int>(i);
+            p.pos[0] = planar[i].x;
+            p.pos[1] = planar[i].y;
+            p.vel[0] = planar[i].vx;
+            p.vel[1] = planar[i].vy;
+            if constexpr (Dim == 3) {
+                std::array<uint32_t, 4> w = philox4x32(i, seed ^ Z_KEY_SALT);
+                p.pos[2] = z_coordinate(w[0]);
+                p.vel[2] = z_coordinate(w[1]) * 0.1f;
+            }
+        }
+    });
+
+    GenericRunResult result;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int step = 0; step < numSteps; step++) {
+        TP_SCOPED_TIMER("particles.update");
+        pool.runStep(n, [&](size_t start, size_t end) {
+            update_particles_t<Boundary>(particles, dt, start, end);
+        });
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    result.wallHitsById.resize(n);
+    for (const auto& p : particles) {
+        result.wallHitsById[p.id] = p.wallHits;
+        result.wallHits += p.wallHits;
+    }
+    return result;
+}
+
+template <int Dim, typename Scalar>
+static GenericRunResult run_with_boundary(BoundaryPolicy boundary, size_t n, int numSteps, double dt, WorkerPool& pool, ParticleRng rng, uint64_t seed) {
+    Scalar step = static_cast<Scalar>(dt);
+    switch (boundary) {
+    case BoundaryPolicy::Wrap: return run_instance<WrapBoundary, Dim, Scalar>(n, numSteps, step, pool, rng, seed);
+    case BoundaryPolicy::Absorb: return run_instance<AbsorbBoundary, Dim, Scalar>(n, numSteps, step, pool, rng, seed);
+    default: return run_instance<ReflectBoundary, Dim, Scalar>(n, numSteps, step, pool, rng, seed);
+    }
+}
+
+GenericRunResult run_generic_particles(const KernelChoice& choice, size_t n, int numSteps, double dt, WorkerPool& pool, ParticleRng rng, uint64_t seed) {
+    if (choice.dim == 3) {
+        if (choice.doublePrecision) return run_with_boundary<3, double>(choice.boundary, n, numSteps, dt, pool, rng, seed);
+        return run_with_boundary<3, float>(choice.boundary, n, numSteps, dt, pool, rng, seed);
+    }
+    if (choice.doublePrecision) return run_with_boundary<2, double>(choice.boundary, n, numSteps, dt, pool, rng, seed);
+    return run_with_boundary<2, float>(choice.boundary, n, numSteps, dt, pool, rng, seed);
+}
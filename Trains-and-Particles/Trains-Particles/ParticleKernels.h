@@ -0,0 +1,120 @@
+/**
+ * @file ParticleKernels.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef PARTICLE_KERNELS_H
+#define PARTICLE_KERNELS_H
+
+#include <array>
+#include <string>
+#include <vector>
+#include "ParticleRng.h"
+
+class WorkerPool;
+
+// Particle engine generalised over the number of dimensions, the scalar type and what happens at
+// the walls of the [-10, 10] box. Every combination is its own template instantiation, so the
+// boundary policy is inlined into the update loop and nothing is decided per particle at run
+// time; run_generic_particles() picks the instantiation once, before the run starts.
+// Particle::update is the 2D float reflecting case and shares ReflectBoundary::axis with it.
+
+// Particle with Dim position and velocity components of type Scalar.
+template <int Dim, typename Scalar>
+struct ParticleT {
+    std::array<Scalar, Dim> pos{}; // Position
+    std::array<Scalar, Dim> vel{}; // Velocity
+    int id = -1; // Unique identifier
+    int wallHits = 0; // Boundary events: reflections, wrap-arounds or the absorbing hit
+    bool alive = true; // False once an absorbing wall has taken the particle
+};
+
+// Reverses the velocity component at a wall, as the original Particle::update.
+struct ReflectBoundary {
+    static const char* name() { return "reflect"; }
+
+    template <typename Scalar>
+    static void axis(Scalar& pos, Scalar& vel, int& wallHits) {
+        if (pos <= Scalar(-10) || pos >= Scalar(10)) {
+            vel *= -1;
+            wallHits++;
+        }
+    }
+    template <int Dim, typename Scalar>
+    static void apply(ParticleT<Dim, Scalar>& p) {
+        for (int d = 0; d < Dim; d++) axis(p.pos[d], p.vel[d], p.wallHits);
+    }
+};
+
+// Periodic box: a particle leaving through one wall comes back in through the opposite one.
+struct WrapBoundary {
+    static const char* name() { return "wrap"; }
+
+    template <int Dim, typename Scalar>
+    static void apply(ParticleT<Dim, Scalar>& p) {
+        for (int d = 0; d < Dim; d++) {
+            if (p.pos[d] < Scalar(-10)) {
+                p.pos[d] += Scalar(20);
+                p.wallHits++;
+            }
+            else if (p.pos[d] >= Scalar(10)) {
+                p.pos[d] -= Scalar(20);
+                p.wallHits++;
+            }
+        }
+    }
+};
+
+// The first wall a particle reaches stops it where it is; it no longer moves or counts hits.
+struct AbsorbBoundary {
+    static const char* name() { return "absorb"; }
+
+    template <int Dim, typename Scalar>
+    static void apply(ParticleT<Dim, Scalar>& p) {
+        bool out = false;
+        for (int d = 0; d < Dim; d++) out |= (p.pos[d] <= Scalar(-10)) | (p.pos[d] >= Scalar(10));
+        // Branch-free: whether a particle is absorbed in a given step is unpredictable
+        p.wallHits += out & p.alive;
+        p.alive = p.alive & !out;
+        Scalar keep = p.alive ? Scalar(1) : Scalar(0);
+        for (int d = 0; d < Dim; d++) p.vel[d] *= keep;
+    }
+};
+
+// Moves particles [start, end) by one step of dt, then applies the boundary policy.
+template <typename Boundary, int Dim, typename Scalar>
+void update_particles_t(std::vector<ParticleT<Dim, Scalar>>& particles, Scalar dt, size_t start, size_t end) {
+    for (size_t i = start; i < end; i++) {
+        ParticleT<Dim, Scalar>& p = particles[i];
+        for (int d = 0; d < Dim; d++) p.pos[d] += p.vel[d] * dt;
+        Boundary::apply(p);
+    }
+}
+
+enum class BoundaryPolicy { Reflect, Wrap, Absorb };
+
+// Reads "reflect", "wrap" or "absorb"; false for anything else.
+bool parse_boundary_policy(const std::string& name, BoundaryPolicy& policy);
+const char* boundary_policy_name(BoundaryPolicy policy);
+
+// Which instantiation run_generic_particles() runs.
+struct KernelChoice {
+    int dim = 2; // 2 or 3
+    bool doublePrecision = false; // double instead of float
+    BoundaryPolicy boundary = BoundaryPolicy::Reflect;
+};
+
+// Result of run_generic_particles().
+struct GenericRunResult {
+    double seconds = 0; // Wall time of the step loop only
+    long long wallHits = 0; // Sum of wallHits over all particles
+    std::vector<int> wallHitsById; // wallHits of each particle (ids are 0..n-1)
+};
+
+// Runs numSteps steps of n particles on the pool with the chosen instantiation. x, y, vx and vy
+// start exactly as initialize_particles_parallel(rng, seed) makes them, so 2D float reflect
+// reproduces the Particle simulation; z and vz come from Philox with a separate key.
+GenericRunResult run_generic_particles(const KernelChoice& choice, size_t n, int numSteps, double dt, WorkerPool& pool,
+                                       ParticleRng rng = ParticleRng::Mt19937, uint64_t seed = 12345);
+
+#endif // PARTICLE_KERNELS_H
@@ -0,0 +1,155 @@
+/**
+ * @file ParticlePipeline.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "ParticlePipeline.h"
+#include "ParticleCollisions.h"
+#include "FrameRenderer.h"
+#include "WorkerPool.h"
+#include "Instrumentation.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+SnapshotQueue::SnapshotQueue(size_t capacity) : capacity(capacity > 0 ? capacity : 1), closed(false), waits(0) {
+}
+
+bool SnapshotQueue::push(FrameSnapshot* snapshot) {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    notFull.wait(lock, [this] { return items.size() < capacity || closed; });
+    if (closed) return false;
+    items.push_back(snapshot);
+    notEmpty.notify_one();
+    return true;
+}
+
+FrameSnapshot* SnapshotQueue::pop() {
+    std::unique_lock<std::mutex> lock(queueMutex);
+    if (items.empty() && !closed) waits++;
+    notEmpty.wait(lock, [this] { return !items.empty() || closed; });
+    if (items.empty()) return nullptr; // Closed and drained
+    FrameSnapshot* snapshot = items.front();
+    items.pop_front();
+    notFull.notify_one();
+    return snapshot;
+}
+
+void SnapshotQueue::close() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    closed = true;
+    notFull.notify_all();
+    notEmpty.notify_all();
+}
+
+uint64_t SnapshotQueue::emptyWaits() const {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return waits;
+}
+
+void compute_frame_stats(const std::vector<Particle>& particles, FrameStats& stats) {
+    stats = FrameStats();
+    for (const Particle& p : particles) {
+        stats.wallHits += p.wallHits;
+        stats.collisions += p.collisions;
+        double speed2 = static_cast<double>(p.vx) * p.vx + static_cast<double>(p.vy) * p.vy;
+        stats.kineticEnergy += 0.5 * speed2;
+        int bin = static_cast<int>(std::sqrt(speed2) / SPEED_BIN_WIDTH);
+        stats.speedHistogram[std::min(bin, SPEED_BINS - 1)]++;
+    }
+}
+
+// Adds the time since start to busy.
+static void add_busy(double& busy, std::chrono::steady_clock::time_point start) {
+    busy += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+PipelineResult run_particle_pipeline(const std::vector<Particle>& initial, int numSteps, float dt, float collisionRadius,
+                                     WorkerPool& pool, const PipelineOptions& options) {
+    PipelineResult result;
+    std::vector<Particle> state = initial; // Owned by the compute stage
+    SpatialGrid grid(2 * collisionRadius);
+
+    // Every snapshot starts in the free queue; the queues can hold all of them, so only
+    // running out of free snapshots makes the compute stage wait
+    const size_t depth = std::max<size_t>(options.depth, 1);
+    std::vector<FrameSnapshot> snapshots(depth);
+    for (FrameSnapshot& s : snapshots) s.particles.resize(initial.size());
+    SnapshotQueue toStats(depth), toRender(depth), freeSnapshots(depth);
+    for (FrameSnapshot& s : snapshots) freeSnapshots.push(&s);
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::thread statsStage([&] {
+        while (FrameSnapshot* frame = toStats.pop()) {
+            auto start = std::chrono::steady_clock::now();
+            TP_SCOPED_TIMER("pipeline.stats");
+            compute_frame_stats(frame->particles, frame->stats);
+            add_busy(result.stageBusySeconds[1], start);
+            toRender.push(frame);
+        }
+        toRender.close(); // Compute has finished and every frame has been passed on
+    });
+
+    std::thread renderStage([&] {
+        FrameRenderer renderer(options.width, options.height); // Reused for every frame
+        char line[160];
+        while (FrameSnapshot* frame = toRender.pop()) {
+            auto start = std::chrono::steady_clock::now();
+            TP_SCOPED_TIMER("render.frame");
+            if (options.draw) {
+                renderer.draw(frame->particles, options.clearScreen); // Clear the console and visualize particles in one write
+                if (options.showStats) {
+                    int n = std::snprintf(line, sizeof(line), "step %llu  wall hits %lld  kinetic energy %.3f\n",
+                                          static_cast<unsigned long long>(frame->step), frame->stats.wallHits, frame->stats.kineticEnergy);
+                    write_stdout(line, static_cast<size_t>(n));
+                }
+            }
+            else {
+                renderer.compose(frame->particles, options.clearScreen);
+            }
+            result.lastStats = frame->stats;
+            result.frames++;
+            add_busy(result.stageBusySeconds[2], start);
+            if (options.framePace.count() > 0) { // Pacing is not work
+                TP_SCOPED_TIMER("render.pace_sleep");
+                std::this_thread::sleep_until(start + options.framePace);
+            }
+            freeSnapshots.push(frame); // Hand the snapshot back to the compute stage
+        }
+    });
+
+    for (int step = 0; step < numSteps; step++) {
+        FrameSnapshot* frame = freeSnapshots.pop(); // Waits while every snapshot is still downstream
+        auto start = std::chrono::steady_clock::now();
+
+        // Each worker updates its [start,end) range; runStep returns once every worker is done
+        {
+            TP_SCOPED_TIMER("particles.update");
+            pool.runStep(state.size(), [&](size_t begin, size_t end) {
+                update_particles(state, dt, begin, end);
+            });
+        }
+        if (collisionRadius > 0) // Particle-particle collisions, after the wall reflections
+        {
+            collide_particles(state, collisionRadius, grid, pool);
+        }
+        pool.runStep(state.size(), [&](size_t begin, size_t end) { // Snapshot copy, also split across the workers
+            std::copy(state.begin() + begin, state.begin() + end, frame->particles.begin() + begin);
+        });
+        frame->step = static_cast<uint64_t>(step) + 1;
+
+        add_busy(result.stageBusySeconds[0], start);
+        toStats.push(frame);
+    }
+    toStats.close();
+    statsStage.join();
+    renderStage.join();
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    result.backpressureWaits = freeSnapshots.emptyWaits();
+    result.particles = state;
+    return result;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file ParticlePipeline.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef PARTICLE_PIPELINE_H
+#define PARTICLE_PIPELINE_H
+
+#include <vector>
+#include <deque>
+#include <array>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include "Trains_and_Particles.h"
+
+class WorkerPool;
+
+const int SPEED_BINS = 8; // Bins of the speed histogram computed by the stats stage
+const float SPEED_BIN_WIDTH = 0.25f; // Width of each bin (the last bin also takes faster particles)
+
+// Reduction of one frame, computed by the stats stage.
+struct FrameStats {
+    long long wallHits = 0; // Total wall hits so far
+    long long collisions = 0; // Total particle-particle collisions so far (each pair counted twice)
+    double kineticEnergy = 0; // Sum of 0.5 * (vx^2 + vy^2), unit mass
+    std::array<uint32_t, SPEED_BINS> speedHistogram{}; // Particles per speed bin
+};
+
+// One frame travelling down the pipeline. Snapshots are allocated once and recycled, so
+// steady-state frames do not allocate.
+struct FrameSnapshot {
+    uint64_t step = 0; // Simulation step the frame shows (1 = after the first update)
+    std::vector<Particle> particles; // Copy of the particle state at that step
+    FrameStats stats; // Filled in by the stats stage
+};
+
+// Blocking bounded FIFO of snapshots between two stages. A fixed set of snapshots circulates
+// through the queues, so a stage that runs ahead soon finds no free snapshot and waits: that
+// is the backpressure that keeps a fast stage from running away from a slow one.
+class SnapshotQueue {
+public:
+    explicit SnapshotQueue(size_t capacity); // Constructor: A queue holding at most capacity snapshots.
+
+    bool push(FrameSnapshot* snapshot); // Waits for room; false if the queue was closed.
+    FrameSnapshot* pop(); // Waits for a snapshot; nullptr once the queue is closed and empty.
+    void close(); // Wakes every waiter; later pushes fail and pops drain what is left.
+    uint64_t emptyWaits() const; // Times pop() had to wait for a snapshot
+
+private:
+    mutable std::mutex queueMutex; // Protects the members below
+    std::condition_variable notFull; // Signalled when a snapshot is popped
+    std::condition_variable notEmpty; // Signalled when a snapshot is pushed
+    std::deque<FrameSnapshot*> items; // Snapshots in FIFO order
+    size_t capacity; // Most snapshots the queue may hold
+    bool closed; // Set by close()
+    uint64_t waits; // Counter behind emptyWaits()
+};
+
+// Options of run_particle_pipeline().
+struct PipelineOptions {
+    size_t depth = 4; // Snapshots in flight; the compute stage waits when all are in use
+    bool draw = true; // Render stage writes each frame to stdout; false only composes it
+    bool clearScreen = true; // Clear the console before each drawn frame
+    bool showStats = false; // Print a statistics line under each drawn frame
+    std::chrono::milliseconds framePace{ 0 }; // Render stage: minimum time each frame stays on screen
+    int width = WIDTH; // Grid width for the render stage
+    int height = HEIGHT; // Grid height for the render stage
+};
+
+// Result of run_particle_pipeline().
+struct PipelineResult {
+    std::vector<Particle> particles; // State after the last step
+    FrameStats lastStats; // Statistics of the last frame
+    uint64_t frames = 0; // Frames that went through every stage
+    double seconds = 0; // Wall time of the whole run
+    std::array<double, 3> stageBusySeconds{}; // Time compute, stats and render spent working (not waiting)
+    uint64_t backpressureWaits = 0; // Times compute waited because every snapshot was still downstream
+};
+
+// Runs numSteps steps of the particle simulation as a three-stage pipeline:
+//   compute (calling thread + pool) -> stats thread -> render thread -> back to compute
+// connected by bounded SnapshotQueues. The compute stage updates the particles (and resolves
+// collisions when collisionRadius > 0) and copies the state into a free snapshot; the stats
+// stage reduces it; the render stage draws it. Every stage works on a different frame at the
+// same time, so a run takes about as long as its slowest stage rather than the sum of all three.
+// The simulation itself is unchanged: the result is identical to updating step by step.
+PipelineResult run_particle_pipeline(const std::vector<Particle>& initial, int numSteps, float dt, float collisionRadius,
+                                     WorkerPool& pool, const PipelineOptions& options);
+
+// Statistics of a set of particles (the work of the stats stage).
+void compute_frame_stats(const std::vector<Particle>& particles, FrameStats& stats);
+
+#endif // PARTICLE_PIPELINE_H
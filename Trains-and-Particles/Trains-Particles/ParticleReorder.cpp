@@ -0,0 +1,109 @@
+/**
+ * @file ParticleReorder.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "ParticleReorder.h"
+#include "Instrumentation.h"
+#include <algorithm>
+
+const int RADIX_BITS = 10; // Digit size: two passes cover the 20-bit codes
+const uint32_t RADIX = 1u << RADIX_BITS;
+const float CELLS_PER_UNIT = (1 << MORTON_BITS_PER_AXIS) / 20.0f; // The box is 20 units wide
+
+// Spreads the low 16 bits of v to the even bit positions.
+static uint32_t spread_bits(uint32_t v) {
+    v &= 0xFFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+uint32_t morton_code(uint32_t cx, uint32_t cy) {
+    return spread_bits(cx) | (spread_bits(cy) << 1);
+}
+
+// Cell column/row of a coordinate, clamped like SpatialGrid::cellCoord (particles may sit just
+// outside the box for one step).
+static uint32_t morton_cell(float v) {
+    int c = static_cast<int>((v + 10.0f) * CELLS_PER_UNIT);
+    return static_cast<uint32_t>(std::min(std::max(c, 0), (1 << MORTON_BITS_PER_AXIS) - 1));
+}
+
+void MortonReorder::radixPass(int shift, WorkerPool& pool) {
+    const size_t n = keys.size();
+    const size_t numWorkers = pool.size();
+    workerCounts.resize(numWorkers);
+    for (auto& counts : workerCounts) counts.clear(); // Workers with an empty range leave theirs empty
+
+    // Histogram of the digit per worker (parallel)
+    pool.runIndexedStep(n, [&](size_t worker, size_t start, size_t end) {
+        std::vector<uint32_t>& counts = workerCounts[worker];
+        counts.assign(RADIX, 0);
+        for (size_t i = start; i < end; i++) counts[(keys[i] >> shift) & (RADIX - 1)]++;
+    });
+
+    // Exclusive prefix sum, digit-major then worker-minor (serial)
+    uint32_t offset = 0;
+    for (uint32_t d = 0; d < RADIX; d++) {
+        for (size_t w = 0; w < numWorkers; w++) {
+            if (workerCounts[w].empty()) continue;
+            uint32_t c = workerCounts[w][d];
+            workerCounts[w][d] = offset;
+            offset += c;
+        }
+    }
+
+    // Scatter (parallel): the same ranges as the histogram, so equal digits keep their order
+    pool.runIndexedStep(n, [&](size_t worker, size_t start, size_t end) {
+        std::vector<uint32_t>& next = workerCounts[worker];
+        for (size_t i = start; i < end; i++) {
+            uint32_t slot = next[(keys[i] >> shift) & (RADIX - 1)]++;
+            keysTmp[slot] = keys[i];
+            orderTmp[slot] = order[i];
+        }
+    });
+    keys.swap(keysTmp);
+    order.swap(orderTmp);
+}
+
+void MortonReorder::reorder(std::vector<Particle>& particles, WorkerPool& pool) {
+    TP_SCOPED_TIMER("particles.reorder");
+    const size_t n = particles.size();
+    keys.resize(n);
+    keysTmp.resize(n);
+    order.resize(n);
+    orderTmp.resize(n);
+    scratch.resize(n);
+    indexById.resize(n);
+
+    pool.runStep(n, [&](size_t start, size_t end) {
+        for (size_t i = start; i < end; i++) {
+            keys[i] = morton_code(morton_cell(particles[i].x), morton_cell(particles[i].y));
+            order[i] = static_cast<uint32_t>(i);
+        }
+    });
+    for (int shift = 0; shift < 2 * MORTON_BITS_PER_AXIS; shift += RADIX_BITS) radixPass(shift, pool);
+
+    // Gather into the new order and record where every id went
+    pool.runStep(n, [&](size_t start, size_t end) {
+        for (size_t k = start; k < end; k++) {
+            scratch[k] = particles[order[k]];
+            indexById[scratch[k].id] = static_cast<uint32_t>(k);
+        }
+    });
+    particles.swap(scratch);
+}
+
+void MortonReorder::restoreIdOrder(std::vector<Particle>& particles, WorkerPool& pool) {
+    const size_t n = particles.size();
+    scratch.resize(n);
+    pool.runStep(n, [&](size_t start, size_t end) {
+        for (size_t k = start; k < end; k++) scratch[particles[k].id] = particles[k]; // Ids are unique, so slots are disjoint
+    });
+    particles.swap(scratch);
+    indexById.clear();
+}
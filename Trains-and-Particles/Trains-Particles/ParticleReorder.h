@@ -0,0 +1,46 @@
+/**
+ * @file ParticleReorder.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef PARTICLE_REORDER_H
+#define PARTICLE_REORDER_H
+
+#include <vector>
+#include <cstdint>
+#include "Trains_and_Particles.h"
+#include "WorkerPool.h"
+
+const int MORTON_BITS_PER_AXIS = 10; // 1024 x 1024 cells over the box, so codes have 20 bits
+
+// Z-order (Morton) code of a cell: the bits of column cx and row cy interleaved, cx in the even bits.
+uint32_t morton_code(uint32_t cx, uint32_t cy);
+
+// Reorders a particle vector along the Z-order curve of the particles' cells, so particles that
+// are close in the box are also close in memory and spatial passes (the collision grid's
+// neighbour queries, the frame renderer) touch far fewer cache lines. The sort is a parallel
+// LSD radix sort on the Morton codes, built like SpatialGrid::build: per-worker histograms,
+// a serial prefix sum and a parallel scatter per digit, which keeps it stable.
+//
+// Particle ids must be 0 .. n-1 (as everywhere particles are created). indexOf() maps an id to
+// its current index, and restoreIdOrder() puts the vector back in id order, e.g. before
+// test_particles_sim, whose output is then unchanged. The particle update does not depend on
+// the order; collisions are resolved in storage order, so with collisions on, a reordered run
+// may resolve simultaneous collisions in a different order.
+class MortonReorder {
+public:
+    void reorder(std::vector<Particle>& particles, WorkerPool& pool); // Sorts the particles by Morton code (stable).
+    void restoreIdOrder(std::vector<Particle>& particles, WorkerPool& pool); // Puts the particles back in id order.
+    size_t indexOf(int id) const { return indexById.empty() ? static_cast<size_t>(id) : indexById[id]; } // Current index of particle id
+
+private:
+    void radixPass(int shift, WorkerPool& pool); // One stable counting-sort pass over a digit of keys
+
+    std::vector<uint32_t> keys, keysTmp; // Morton codes, sorted alongside order
+    std::vector<uint32_t> order, orderTmp; // Old index of each sorted position
+    std::vector<uint32_t> indexById; // Current index of each id (empty = identity)
+    std::vector<Particle> scratch; // Gather target, swapped with the particles
+    std::vector<std::vector<uint32_t>> workerCounts; // Per-worker digit histograms, turned into scatter offsets
+};
+
+#endif // PARTICLE_REORDER_H
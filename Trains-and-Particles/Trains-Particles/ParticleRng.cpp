@@ -0,0 +1,129 @@
+/**
+ * @file ParticleRng.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "ParticleRng.h"
+#include "ParticleSoA.h"
+#include "WorkerPool.h"
+#include <algorithm>
+
+const size_t WORDS_PER_PARTICLE = 8; // x, y, vx, vy, two 32-bit words per double
+const size_t RNG_BATCH = 1 << 16; // Particles per mt19937 batch (2 MB of words)
+
+bool parse_particle_rng(const std::string& name, ParticleRng& rng) {
+    if (name == "mt19937") rng = ParticleRng::Mt19937;
+    else if (name == "philox") rng = ParticleRng::Philox;
+    else return false;
+    return true;
+}
+
+const char* particle_rng_name(ParticleRng rng) {
+    return rng == ParticleRng::Philox ? "philox" : "mt19937";
+}
+
+std::array<uint32_t, 4> philox4x32(uint64_t counter, uint64_t key) {
+    const uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57; // Round multipliers
+    const uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85; // Key schedule (golden ratio, sqrt(3) - 1)
+    uint32_t c0 = static_cast<uint32_t>(counter), c1 = static_cast<uint32_t>(counter >> 32), c2 = 0, c3 = 0;
+    uint32_t k0 = static_cast<uint32_t>(key), k1 = static_cast<uint32_t>(key >> 32);
+    for (int round = 0; round < 10; round++) {
+        uint64_t p0 = static_cast<uint64_t>(M0) * c0;
+        uint64_t p1 = static_cast<uint64_t>(M1) * c2;
+        uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+        c1 = static_cast<uint32_t>(p1);
+        c3 = static_cast<uint32_t>(p0);
+        c0 = n0;
+        c2 = n2;
+        k0 += W0;
+        k1 += W1;
+    }
+    return { c0, c1, c2, c3 };
+}
+
+// Replays words drawn earlier from a std::mt19937, so a distribution fed by it returns exactly
+// what it would have returned from the generator itself.
+class ReplayedMt19937 {
+public:
+    using result_type = std::mt19937::result_type;
+    explicit ReplayedMt19937(const uint32_t* words) : next(words) {}
+    static constexpr result_type min() { return std::mt19937::min(); }
+    static constexpr result_type max() { return std::mt19937::max(); }
+    result_type operator()() { return *next++; }
+
+private:
+    const uint32_t* next; // Next word to hand out
+};
+
+// Value in [-10, 10) from one 32-bit word.
+static inline float philox_coordinate(uint32_t word) {
+    return static_cast<float>(-10.0 + 20.0 * (word * (1.0 / 4294967296.0)));
+}
+
+// Fills particles [0, n) through set(i, x, y, vx, vy) with the chosen generator.
+template <typename Set>
+static void fill_parallel(size_t n, WorkerPool& pool, ParticleRng rng, std::mt19937& gen, uint64_t seed, const Set& set) {
+    if (rng == ParticleRng::Philox) {
+        pool.runStep(n, [&](size_t start, size_t end) {
+            for (size_t i = start; i < end; i++) {
+                std::array<uint32_t, 4> w = philox4x32(i, seed);
+                set(i, philox_coordinate(w[0]), philox_coordinate(w[1]), philox_coordinate(w[2]) * 0.1f, philox_coordinate(w[3]) * 0.1f);
+            }
+        });
+        return;
+    }
+
+    std::vector<uint32_t> words(std::min(n, RNG_BATCH) * WORDS_PER_PARTICLE);
+    for (size_t first = 0; first < n; first += RNG_BATCH) {
+        size_t count = std::min(RNG_BATCH, n - first);
+        for (size_t k = 0; k < count * WORDS_PER_PARTICLE; k++) words[k] = gen(); // The serial part: raw words only
+        pool.runStep(count, [&](size_t start, size_t end) {
+            ReplayedMt19937 replay(words.data() + start * WORDS_PER_PARTICLE);
+            std::uniform_real_distribution<> dis(-10.0, 10.0); // Same distribution as initialize_particles
+            for (size_t i = start; i < end; i++) {
+                float x = dis(replay); // Same draw order: x, y, vx, vy
+                float y = dis(replay);
+                float vx = dis(replay) * 0.1f;
+                float vy = dis(replay) * 0.1f;
+                set(first + i, x, y, vx, vy);
+            }
+        });
+    }
+}
+
+void initialize_particles_parallel(std::vector<Particle>& particles, WorkerPool& pool, ParticleRng rng, uint64_t seed) {
+    std::mt19937 gen(static_cast<std::mt19937::result_type>(seed));
+    fill_parallel(particles.size(), pool, rng, gen, seed, [&particles](size_t i, float x, float y, float vx, float vy) {
+        Particle& p = particles[i];
+        p.x = x;
+        p.y = y;
+        p.vx = vx;
+        p.vy = vy;
+    });
+}
+
+void initialize_particles_parallel(std::vector<Particle>& particles, WorkerPool& pool, std::mt19937& gen) {
+    fill_parallel(particles.size(), pool, ParticleRng::Mt19937, gen, 0, [&particles](size_t i, float x, float y, float vx, float vy) {
+        Particle& p = particles[i];
+        p.x = x;
+        p.y = y;
+        p.vx = vx;
+        p.vy = vy;
+    });
+}
+
+void initialize_particles_soa_parallel(ParticleSoA& p, size_t n, WorkerPool& pool, ParticleRng rng, uint64_t seed) {
+    p.resize(n);
+    std::mt19937 gen(static_cast<std::mt19937::result_type>(seed));
+    fill_parallel(n, pool, rng, gen, seed, [&p](size_t i, float x, float y, float vx, float vy) {
+        p.x[i] = x;
+        p.y[i] = y;
+        p.vx[i] = vx;
+        p.vy[i] = vy;
+        p.id[i] = static_cast<int>(i);
+        p.wallHits[i] = 0;
+        p.collisions[i] = 0;
+    });
+}
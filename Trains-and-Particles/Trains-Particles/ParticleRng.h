@@ -0,0 +1,50 @@
+/**
+ * @file ParticleRng.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef PARTICLE_RNG_H
+#define PARTICLE_RNG_H
+
+#include <vector>
+#include <array>
+#include <random>
+#include <string>
+#include <cstdint>
+#include "Trains_and_Particles.h"
+
+class WorkerPool;
+class ParticleSoA;
+
+// Random number source of the parallel initialisers.
+enum class ParticleRng {
+    Mt19937, // Compatibility: exactly the values of initialize_particles (std::mt19937 seed 12345, x, y, vx, vy per particle)
+    Philox // Counter-based Philox4x32-10: one block of four words per particle, keyed by the seed
+};
+
+bool parse_particle_rng(const std::string& name, ParticleRng& rng); // "mt19937" or "philox"; false for anything else.
+const char* particle_rng_name(ParticleRng rng); // Name accepted by parse_particle_rng().
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC'11).
+// The output is a pure function of (counter, key), so any particle's numbers can be computed on
+// any thread in any order without a shared generator state.
+std::array<uint32_t, 4> philox4x32(uint64_t counter, uint64_t key);
+
+// Parallel versions of initialize_particles / initialize_particles_soa. Like the serial versions,
+// the AoS fill only sets positions and velocities; the SoA fill also sets ids and clears counters.
+//
+// Mt19937: mt19937 cannot jump ahead cheaply, so the raw 32-bit words are still drawn one after
+// another on the calling thread, a batch at a time; the workers then turn each batch into
+// positions and velocities with the same std::uniform_real_distribution (which always takes two
+// words per double), so every value is bit-for-bit the serial one.
+// Philox: every particle's block is computed independently, so the whole fill is parallel.
+void initialize_particles_parallel(std::vector<Particle>& particles, WorkerPool& pool, ParticleRng rng = ParticleRng::Mt19937,
+                                   uint64_t seed = 12345);
+void initialize_particles_soa_parallel(ParticleSoA& particles, size_t n, WorkerPool& pool, ParticleRng rng = ParticleRng::Mt19937,
+                                       uint64_t seed = 12345);
+
+// Compatibility fill from the given generator, leaving it in the state after the last draw,
+// like initialize_particles(particles, gen) (used when the state goes into a checkpoint).
+void initialize_particles_parallel(std::vector<Particle>& particles, WorkerPool& pool, std::mt19937& gen);
+
+#endif // PARTICLE_RNG_H
@@ -0,0 +1,150 @@
+/**
+ * @file ParticleSoA.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "ParticleSoA.h"
+#include <random>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SOA_USE_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SOA_USE_SSE2 1
+#endif
+
+// Copies every field of the array-of-structs vector into its own array.
+ParticleSoA::ParticleSoA(const std::vector<Particle>& particles) {
+    resize(particles.size());
+    for (size_t i = 0; i < particles.size(); i++) {
+        x[i] = particles[i].x;
+        y[i] = particles[i].y;
+        vx[i] = particles[i].vx;
+        vy[i] = particles[i].vy;
+        id[i] = particles[i].id;
+        wallHits[i] = particles[i].wallHits;
+        collisions[i] = particles[i].collisions;
+    }
+}
+
+// Resizes every field array; new particles are zeroed like Particle's default constructor (id -1).
+void ParticleSoA::resize(size_t n) {
+    x.resize(n, 0.0f);
+    y.resize(n, 0.0f);
+    vx.resize(n, 0.0f);
+    vy.resize(n, 0.0f);
+    id.resize(n, -1);
+    wallHits.resize(n, 0);
+    collisions.resize(n, 0);
+}
+
+// Rebuilds the array-of-structs vector, e.g. for visualize_particles or test_particles_sim.
+std::vector<Particle> ParticleSoA::toParticles() const {
+    std::vector<Particle> particles(size());
+    for (size_t i = 0; i < size(); i++) {
+        particles[i].x = x[i];
+        particles[i].y = y[i];
+        particles[i].vx = vx[i];
+        particles[i].vy = vy[i];
+        particles[i].id = id[i];
+        particles[i].wallHits = wallHits[i];
+        particles[i].collisions = collisions[i];
+    }
+    return particles;
+}
+
+void initialize_particles_soa(ParticleSoA& p, size_t n) {
+    p.resize(n);
+    std::mt19937 gen(12345); // Same fixed seed as initialize_particles
+    std::uniform_real_distribution<> dis(-10.0, 10.0); // Distribution for position and velocity
+
+    for (size_t i = 0; i < n; i++) { // Same draw order: x, y, vx, vy per particle
+        p.x[i] = dis(gen);
+        p.y[i] = dis(gen);
+        p.vx[i] = dis(gen) * 0.1f;
+        p.vy[i] = dis(gen) * 0.1f;
+        p.id[i] = static_cast<int>(i);
+        p.wallHits[i] = 0;
+        p.collisions[i] = 0;
+    }
+}
+
+// Scalar, branch-free version of Particle::update for one particle.
+// Negating the velocity is a sign flip, and a wall hit adds the 0/1 comparison result.
+static inline void update_one(ParticleSoA& p, float dt, size_t i) {
+    float nx = p.x[i] + p.vx[i] * dt; // Update the x-coordinate of the particle's position
+    float ny = p.y[i] + p.vy[i] * dt; // Update the y-coordinate of the particle's position
+    int hitX = (nx <= -10) | (nx >= 10); // 1 if the particle hit a vertical wall
+    int hitY = (ny <= -10) | (ny >= 10); // 1 if the particle hit a horizontal wall
+    p.x[i] = nx;
+    p.y[i] = ny;
+    p.vx[i] = hitX ? -p.vx[i] : p.vx[i]; // Compiles to a select, not a branch
+    p.vy[i] = hitY ? -p.vy[i] : p.vy[i];
+    p.wallHits[i] += hitX + hitY; // Increment the wall hit count
+}
+
+void update_particles_soa(ParticleSoA& p, float dt, size_t start, size_t end) {
+    size_t i = start;
+
+#if defined(SOA_USE_AVX2)
+    const __m256 vdt = _mm256_set1_ps(dt);
+    const __m256 lo = _mm256_set1_ps(-10.0f);
+    const __m256 hi = _mm256_set1_ps(10.0f);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    for (; i + 8 <= end; i += 8) {
+        __m256 vx = _mm256_loadu_ps(&p.vx[i]);
+        __m256 vy = _mm256_loadu_ps(&p.vy[i]);
+        // Separate multiply and add (no FMA) so rounding matches the scalar kernel exactly
+        __m256 x = _mm256_add_ps(_mm256_loadu_ps(&p.x[i]), _mm256_mul_ps(vx, vdt));
+        __m256 y = _mm256_add_ps(_mm256_loadu_ps(&p.y[i]), _mm256_mul_ps(vy, vdt));
+        __m256 hitX = _mm256_or_ps(_mm256_cmp_ps(x, lo, _CMP_LE_OQ), _mm256_cmp_ps(x, hi, _CMP_GE_OQ));
+        __m256 hitY = _mm256_or_ps(_mm256_cmp_ps(y, lo, _CMP_LE_OQ), _mm256_cmp_ps(y, hi, _CMP_GE_OQ));
+        _mm256_storeu_ps(&p.x[i], x);
+        _mm256_storeu_ps(&p.y[i], y);
+        _mm256_storeu_ps(&p.vx[i], _mm256_xor_ps(vx, _mm256_and_ps(hitX, sign))); // Reverse velocity where hit
+        _mm256_storeu_ps(&p.vy[i], _mm256_xor_ps(vy, _mm256_and_ps(hitY, sign)));
+        // Comparison masks are all ones (-1) per hit lane, so subtracting them counts the hits
+        __m256i hits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&p.wallHits[i]));
+        hits = _mm256_sub_epi32(hits, _mm256_castps_si256(hitX));
+        hits = _mm256_sub_epi32(hits, _mm256_castps_si256(hitY));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&p.wallHits[i]), hits);
+    }
+#elif defined(SOA_USE_SSE2)
+    const __m128 vdt = _mm_set1_ps(dt);
+    const __m128 lo = _mm_set1_ps(-10.0f);
+    const __m128 hi = _mm_set1_ps(10.0f);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    for (; i + 4 <= end; i += 4) {
+        __m128 vx = _mm_loadu_ps(&p.vx[i]);
+        __m128 vy = _mm_loadu_ps(&p.vy[i]);
+        __m128 x = _mm_add_ps(_mm_loadu_ps(&p.x[i]), _mm_mul_ps(vx, vdt));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(&p.y[i]), _mm_mul_ps(vy, vdt));
+        __m128 hitX = _mm_or_ps(_mm_cmple_ps(x, lo), _mm_cmpge_ps(x, hi));
+        __m128 hitY = _mm_or_ps(_mm_cmple_ps(y, lo), _mm_cmpge_ps(y, hi));
+        _mm_storeu_ps(&p.x[i], x);
+        _mm_storeu_ps(&p.y[i], y);
+        _mm_storeu_ps(&p.vx[i], _mm_xor_ps(vx, _mm_and_ps(hitX, sign)));
+        _mm_storeu_ps(&p.vy[i], _mm_xor_ps(vy, _mm_and_ps(hitY, sign)));
+        __m128i hits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&p.wallHits[i]));
+        hits = _mm_sub_epi32(hits, _mm_castps_si128(hitX));
+        hits = _mm_sub_epi32(hits, _mm_castps_si128(hitY));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&p.wallHits[i]), hits);
+    }
+#endif
+
+    for (; i < end; i++) { // Remainder (or everything, without SIMD)
+        update_one(p, dt, i);
+    }
+}
+
+const char* soa_kernel_isa() {
+#if defined(SOA_USE_AVX2)
+    return "AVX2";
+#elif defined(SOA_USE_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,43 @@
+/**
+ * @file ParticleSoA.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef PARTICLE_SOA_H
+#define PARTICLE_SOA_H
+
+#include <vector>
+#include "Trains_and_Particles.h"
+
+// ParticleSoA stores the same state as std::vector<Particle>, but as one contiguous
+// array per field (structure of arrays), so the update kernel can load 4 or 8
+// particles' positions and velocities with a single SIMD instruction.
+class ParticleSoA {
+public:
+    std::vector<float> x, y; // Positions of the particles
+    std::vector<float> vx, vy; // Velocities of the particles
+    std::vector<int> id; // Unique identifier for each particle
+    std::vector<int> wallHits; // Number of times each particle hits a wall
+    std::vector<int> collisions; // Number of particle-particle collisions of each particle
+
+    ParticleSoA() {} // Default constructor: empty store
+    explicit ParticleSoA(const std::vector<Particle>& particles); // Copies an array-of-structs particle vector.
+
+    size_t size() const { return x.size(); } // Number of particles in the store
+    void resize(size_t n); // Resizes every field array to n particles.
+    std::vector<Particle> toParticles() const; // Converts back to an array-of-structs particle vector.
+};
+
+// Fills the store with n particles (ids 0..n-1) drawing exactly the same mt19937 sequence as
+// initialize_particles, so the SoA and AoS simulations start from identical states.
+void initialize_particles_soa(ParticleSoA& particles, size_t n);
+
+// Updates particles [start, end) of the store. Same maths and wall rule as Particle::update,
+// but branch-free and vectorised with AVX2 or SSE when available, scalar otherwise.
+// Positions, velocities and wallHits are bit-for-bit identical to the scalar kernel.
+void update_particles_soa(ParticleSoA& particles, float dt, size_t start, size_t end);
+
+// Name of the instruction set the SoA kernel was compiled for ("AVX2", "SSE2" or "scalar").
+const char* soa_kernel_isa();
+
+#endif // PARTICLE_SOA_H
@@ -0,0 +1,126 @@
+/**
+ * @file RailwayEventSim.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "RailwayEventSim.h"
+#include <algorithm>
+#include <deque>
+#include <queue>
+
+namespace {
+
+// A scheduled train movement.
+struct MoveEvent {
+    uint64_t time; // Virtual time of the move
+    uint64_t order; // Insertion order; breaks ties so equal times run first-come first-served
+    uint32_t train; // Train that moves
+    bool operator>(const MoveEvent& other) const {
+        return time != other.time ? time > other.time : order > other.order;
+    }
+};
+
+// What each train is doing, the event-driven equivalent of the locals of RailwayNetwork::runTrain.
+struct TrainState {
+    int position = 0; // Current cell
+    int step = 0; // Moves completed
+    std::vector<int> needed; // Sections still to take before entering the next run
+    std::vector<int> held; // Sections currently held
+};
+
+} // namespace
+
+EventSimResult simulate_discrete_events(const RailwayNetwork& network, int numSteps, uint64_t ticksPerStep) {
+    EventSimResult result;
+    const int noTrain = -1;
+    std::vector<int> owner(network.sectionCount(), noTrain); // Train holding each section
+    std::vector<std::deque<uint32_t>> waiting(network.sectionCount()); // Trains blocked on each section
+    std::vector<TrainState> trains(network.trainCount());
+    std::priority_queue<MoveEvent, std::vector<MoveEvent>, std::greater<MoveEvent>> queue;
+    uint64_t order = 0;
+
+    auto schedule = [&](uint64_t time, uint32_t train) { queue.push({ time, order++, train }); };
+    auto record = [&](uint32_t train, int section, char kind, uint64_t now) {
+        result.events.push_back({ result.events.size(), now, train, static_cast<uint16_t>(section), kind, 0 });
+    };
+    auto release = [&](uint32_t train, int section, uint64_t now) {
+        record(train, section, 'L', now);
+        owner[section] = noTrain;
+        TrainState& t = trains[train];
+        t.held.erase(std::find(t.held.begin(), t.held.end(), section));
+        if (!waiting[section].empty()) { // Wake the first train waiting for this section
+            schedule(now, waiting[section].front());
+            waiting[section].pop_front();
+        }
+    };
+
+    for (uint32_t t = 0; t < trains.size(); t++) {
+        trains[t].position = network.route(t).start;
+        if (numSteps > 0) schedule(0, t);
+    }
+
+    while (!queue.empty()) {
+        MoveEvent ev = queue.top();
+        queue.pop();
+        result.processedEvents++;
+        result.virtualTime = ev.time;
+
+        TrainState& t = trains[ev.train];
+        const std::vector<int>& cells = network.route(ev.train).cells;
+        const int length = static_cast<int>(cells.size());
+        int current = cells[t.position];
+        int next = cells[(t.position + 1) % length];
+
+        if (current == -1 && next != -1 && t.held.empty() && t.needed.empty()) { // First attempt to enter a run
+            for (int q = 1; q < length && cells[(t.position + q) % length] != -1; q++) {
+                t.needed.push_back(cells[(t.position + q) % length]);
+            }
+            std::sort(t.needed.begin(), t.needed.end()); // Same global order as the threaded model
+            t.needed.erase(std::unique(t.needed.begin(), t.needed.end()), t.needed.end());
+            std::reverse(t.needed.begin(), t.needed.end()); // Taken from the back: lowest index first
+        }
+
+        bool blocked = false;
+        while (!t.needed.empty()) { // Take the sections in order; stop at the first busy one
+            int section = t.needed.back();
+            if (owner[section] != noTrain) {
+                waiting[section].push_back(ev.train); // Rescheduled by release()
+                result.blockedWaits++;
+                blocked = true;
+                break;
+            }
+            owner[section] = static_cast<int>(ev.train);
+            record(ev.train, section, 'E', ev.time);
+            t.held.push_back(section);
+            t.needed.pop_back();
+        }
+        if (blocked) continue;
+
+        if (current != -1) {
+            record(ev.train, current, 'O', ev.time); // On the shared section
+        }
+        if (current != -1 && next != current) {
+            release(ev.train, current, ev.time); // Leaving this section
+        }
+
+        t.position = (t.position + 1) % length; // Moves the train forward and loops around the route
+        t.step++;
+        if (t.step < numSteps) {
+            schedule(ev.time + ticksPerStep, ev.train);
+        }
+        else {
+            while (!t.held.empty()) release(ev.train, t.held.back(), ev.time); // Stopped inside a run
+        }
+    }
+    return result;
+}
+
+std::vector<std::string> to_trains_log(const RailwayNetwork& network, const std::vector<RailEvent>& events) {
+    std::vector<std::string> log;
+    log.reserve(events.size());
+    for (const RailEvent& e : events) {
+        log.push_back(network.route(e.train).name + "- " + e.kind);
+    }
+    return log;
+}
@@ -0,0 +1,33 @@
+/**
+ * @file RailwayEventSim.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef RAILWAY_EVENT_SIM_H
+#define RAILWAY_EVENT_SIM_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "RailwayNetwork.h"
+
+// Result of a discrete-event run.
+struct EventSimResult {
+    std::vector<RailEvent> events; // Same log a threaded RailwayNetwork::run() would produce
+    uint64_t virtualTime = 0; // Virtual clock when the last train finished (in ticks)
+    uint64_t processedEvents = 0; // Train movements taken off the event queue
+    uint64_t blockedWaits = 0; // Times a train had to wait for a section held by another train
+};
+
+// Runs the trains of a network on a virtual clock instead of threads and sleeps.
+// Every train move is an event in a priority queue ordered by (time, insertion order); a move
+// takes ticksPerStep ticks. Sections are taken in the same order as RailwayNetwork::runTrain
+// (increasing index, one batch per run of shared cells). A train that finds a section busy
+// waits in that section's FIFO queue and is rescheduled, at the current virtual time, when the
+// section is released. Nothing sleeps, so thousands of moves take well under a millisecond.
+EventSimResult simulate_discrete_events(const RailwayNetwork& network, int numSteps, uint64_t ticksPerStep = 1000);
+
+// Formats network events as trains_log strings ("Train A- E"), the format isSimulationCorrect reads.
+std::vector<std::string> to_trains_log(const RailwayNetwork& network, const std::vector<RailEvent>& events);
+
+#endif // RAILWAY_EVENT_SIM_H
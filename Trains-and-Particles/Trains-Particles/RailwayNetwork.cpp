@@ -0,0 +1,192 @@
+/**
+ * @file RailwayNetwork.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "RailwayNetwork.h"
+#include <algorithm>
+#include <random>
+#include <thread>
+
+RailwayNetwork::RailwayNetwork(int numSections) : numSections(numSections) {
+}
+
+bool RailwayNetwork::addTrain(const TrainRoute& route, std::string& reason) {
+    const int length = static_cast<int>(route.cells.size());
+    if (length == 0) {
+        reason = route.name + ": the route has no cells";
+        return false;
+    }
+    if (route.start < 0 || route.start >= length || route.cells[route.start] != -1) {
+        reason = route.name + ": the train must start on its own (private) track";
+        return false;
+    }
+    // Walk the loop from the cell after start: start is private track, so a run of shared cells
+    // that wraps past the end of cells is still checked as one block
+    std::vector<int> seenInRun; // Sections already passed in the current run of shared cells
+    for (int q = 1; q <= length; q++) {
+        int p = (route.start + q) % length;
+        int section = route.cells[p];
+        if (section < -1 || section >= sectionCount()) {
+            reason = route.name + ": cell " + std::to_string(p) + " refers to an unknown section";
+            return false;
+        }
+        if (section == -1) {
+            seenInRun.clear();
+        }
+        else if (route.cells[(p + length - 1) % length] != section) { // A new section block starts here
+            if (std::find(seenInRun.begin(), seenInRun.end(), section) != seenInRun.end()) {
+                reason = route.name + ": section " + std::to_string(section) + " appears twice in one run of shared cells";
+                return false;
+            }
+            seenInRun.push_back(section);
+        }
+    }
+    routes.push_back(route);
+    return true;
+}
+
+void RailwayNetwork::record(uint32_t train, uint32_t section, char kind) {
+    recorder.record(train, static_cast<uint16_t>(section), kind);
+}
+
+void RailwayNetwork::run(int numSteps, std::chrono::milliseconds stepTime) {
+    eventLog.clear();
+    recorder.reset();
+    sectionLocks.clear(); // The guards are sized for the trains (MCS keeps a queue node per train)
+    for (int s = 0; s < numSections; s++) sectionLocks.push_back(make_track_lock(lockPolicy, routes.size())); // All sections share one wait and one hold metric
+    std::vector<std::thread> threads;
+    threads.reserve(routes.size());
+    for (size_t t = 0; t < routes.size(); t++) {
+        threads.emplace_back(&RailwayNetwork::runTrain, this, t, numSteps, stepTime);
+    }
+    for (auto& thread : threads) thread.join(); // Every train finishes its steps; nothing is left detached
+    eventLog = recorder.merge();
+}
+
+void RailwayNetwork::runTrain(size_t train, int numSteps, std::chrono::milliseconds stepTime) {
+    const std::vector<int>& cells = routes[train].cells;
+    const int length = static_cast<int>(cells.size());
+    const uint32_t id = static_cast<uint32_t>(train);
+    std::vector<int> held; // Sections this train currently holds
+    int position = routes[train].start;
+
+    for (int step = 0; step < numSteps; step++) {
+        int current = cells[position];
+        int next = cells[(position + 1) % length];
+
+        if (current == -1 && next != -1) { // About to enter a run of shared cells: take all of its sections
+            std::vector<int> needed;
+            for (int q = 1; q < length && cells[(position + q) % length] != -1; q++) {
+                needed.push_back(cells[(position + q) % length]);
+            }
+            std::sort(needed.begin(), needed.end()); // Global order: lowest section index first
+            needed.erase(std::unique(needed.begin(), needed.end()), needed.end());
+            for (int section : needed) {
+                sectionLocks[section]->acquire(id);
+                record(id, section, 'E');
+                held.push_back(section);
+            }
+        }
+
+        if (current != -1) {
+            record(id, current, 'O'); // The train is on the shared section
+        }
+
+        if (current != -1 && next != current) { // Leaving this section (maybe into the next one of the run)
+            record(id, current, 'L');
+            sectionLocks[current]->release(id);
+            held.erase(std::find(held.begin(), held.end(), current));
+        }
+
+        position = (position + 1) % length; // Moves the train forward and loops around the route
+        if (stepTime.count() > 0) std::this_thread::sleep_for(stepTime);
+    }
+
+    for (int section : held) { // Stopped inside a run: leave it so other trains can finish too
+        record(id, section, 'L');
+        sectionLocks[section]->release(id);
+    }
+}
+
+std::vector<bool> RailwayNetwork::trainsExpectedToEnter(int numSteps) const {
+    std::vector<bool> expected(routes.size(), false);
+    for (size_t t = 0; t < routes.size(); t++) {
+        const std::vector<int>& cells = routes[t].cells;
+        const int length = static_cast<int>(cells.size());
+        int position = routes[t].start;
+        for (int step = 0; step < std::min(numSteps, length); step++) { // Same entry condition as runTrain
+            if (cells[position] == -1 && cells[(position + 1) % length] != -1) {
+                expected[t] = true;
+                break;
+            }
+            position = (position + 1) % length;
+        }
+    }
+    return expected;
+}
+
+std::unique_ptr<RailwayNetwork> RailwayNetwork::classic() {
+    std::unique_ptr<RailwayNetwork> network(new RailwayNetwork(1));
+    std::string reason;
+    for (const char* name : { "Train A", "Train B" }) {
+        TrainRoute route;
+        route.name = name;
+        route.cells.assign(25, -1); // Trains loop around 25 positions
+        for (int p = 10; p <= 15; p++) route.cells[p] = 0; // sharedSectionStart..sharedSectionEnd
+        network->addTrain(route, reason);
+    }
+    return network;
+}
+
+std::unique_ptr<RailwayNetwork> RailwayNetwork::generated(int numTrains, int numSections, int routeLength, int sectionsPerRoute, unsigned seed) {
+    std::unique_ptr<RailwayNetwork> network(new RailwayNetwork(numSections));
+    std::mt19937 gen(seed);
+    std::vector<int> sections(numSections);
+    for (int s = 0; s < numSections; s++) sections[s] = s;
+    std::string reason;
+
+    for (int t = 0; t < numTrains; t++) {
+        TrainRoute route;
+        route.name = "Train " + std::to_string(t);
+        route.cells.assign(routeLength, -1);
+        std::shuffle(sections.begin(), sections.end(), gen); // Distinct sections for this route
+
+        int cursor = 1; // Cell 0 stays private: the start
+        int count = std::min(sectionsPerRoute, numSections);
+        for (int k = 0; k < count; k++) {
+            int blockLength = 1 + static_cast<int>(gen() % 3);
+            int gap = (k > 0 && gen() % 3 == 0) ? 0 : 1 + static_cast<int>(gen() % 3); // Gap 0: back to back sections
+            if (cursor + gap + blockLength >= routeLength) break; // Keep the last cell private
+            cursor += gap;
+            for (int c = 0; c < blockLength; c++) route.cells[cursor++] = sections[k];
+        }
+        network->addTrain(route, reason);
+    }
+    return network;
+}
+
+// Train names, for validation messages.
+static std::vector<std::string> train_names(const RailwayNetwork& network) {
+    std::vector<std::string> names;
+    names.reserve(network.trainCount());
+    for (size_t t = 0; t < network.trainCount(); t++) names.push_back(network.route(t).name);
+    return names;
+}
+
+bool isNetworkSimulationCorrect(const RailwayNetwork& network, const std::vector<RailEvent>& log,
+                                const std::vector<bool>& expectedToEnter, std::string& reason, int& record_number) {
+    StreamingTrainValidator validator(network.trainCount(), network.sectionCount(), train_names(network), expectedToEnter);
+    validator.consume(log.data(), log.size());
+    validator.finish();
+    record_number = validator.recordNumber();
+    reason = validator.reason();
+    return validator.ok();
+}
+
+bool isNetworkSimulationCorrect(const RailwayNetwork& network, const std::vector<RailEvent>& log,
+                                const std::vector<bool>& expectedToEnter, WorkerPool& pool, std::string& reason, int& record_number) {
+    return validate_events_parallel(log, network.trainCount(), network.sectionCount(), train_names(network), expectedToEnter,
+                                    pool, reason, record_number);
+}
@@ -0,0 +1,79 @@
+/**
+ * @file RailwayNetwork.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef RAILWAY_NETWORK_H
+#define RAILWAY_NETWORK_H
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include "TrainEventLog.h"
+#include "Instrumentation.h"
+#include "TrackLock.h"
+
+class WorkerPool;
+
+// A train's route: a closed loop of track cells. route[p] is the shared section that cell p
+// belongs to, or -1 for the train's own track. RailwaySystem's Train A is a 25-cell loop with
+// cells 10..15 in section 0.
+struct TrainRoute {
+    std::string name; // Name used in messages, e.g. "Train A"
+    std::vector<int> cells; // Section of each cell, -1 for private track
+    int start = 0; // Starting cell (must be private track)
+};
+
+// RailwayNetwork is the data-driven generalisation of RailwaySystem: any number of trains,
+// each on its own route, and any number of shared sections, each guarded by its own TrackLock
+// (std::mutex unless setLockPolicy() chooses another policy).
+//
+// A run of consecutive shared cells may cross several sections. Before its first cell a train
+// acquires every section of the run, always in increasing section index, and it releases each
+// section as it leaves it. A train never holds a section while waiting outside a batch, and
+// every batch is taken in the same global order, so the network cannot deadlock.
+class RailwayNetwork {
+public:
+    explicit RailwayNetwork(int numSections); // Constructor: A network with numSections shared sections.
+
+    bool addTrain(const TrainRoute& route, std::string& reason); // Adds a train; false (with reason) if the route is invalid.
+    void run(int numSteps, std::chrono::milliseconds stepTime); // Runs every train for numSteps moves on its own thread and joins them.
+    void setLockPolicy(TrackLockPolicy policy) { lockPolicy = policy; } // Guard used for the sections from the next run() on (one train per section).
+
+    size_t trainCount() const { return routes.size(); }
+    int sectionCount() const { return numSections; }
+    const TrainRoute& route(size_t train) const { return routes[train]; }
+    const std::vector<RailEvent>& events() const { return eventLog; } // Log of the last run().
+    std::vector<bool> trainsExpectedToEnter(int numSteps) const; // Trains that reach a shared section within numSteps moves.
+
+    static std::unique_ptr<RailwayNetwork> classic(); // Trains A and B sharing cells 10..15, as in RailwaySystem.
+    // numTrains trains on routes of routeLength cells, each crossing sectionsPerRoute of the
+    // numSections sections (sometimes back to back, so several are needed at once).
+    static std::unique_ptr<RailwayNetwork> generated(int numTrains, int numSections, int routeLength, int sectionsPerRoute, unsigned seed);
+
+private:
+    void runTrain(size_t train, int numSteps, std::chrono::milliseconds stepTime); // Body of each train thread.
+    void record(uint32_t train, uint32_t section, char kind); // Records an event in the calling train's buffer (no shared lock).
+
+    std::vector<TrainRoute> routes; // One route per train
+    int numSections; // Shared sections, numbered 0 .. numSections-1
+    TrackLockPolicy lockPolicy = TrackLockPolicy::Mutex; // Guard policy of the sections
+    std::vector<std::unique_ptr<TrackLock>> sectionLocks; // One guard per shared section, made by run() for the current trains
+    EventRecorder recorder; // Per-thread event buffers of the current run
+    std::vector<RailEvent> eventLog; // Events of the last run, merged in sequence order
+};
+
+// Validates a network log the way isSimulationCorrect validates trains_log, for any number of
+// trains and sections, by streaming it through a StreamingTrainValidator.
+// On failure, reason and record_number describe the first bad record.
+bool isNetworkSimulationCorrect(const RailwayNetwork& network, const std::vector<RailEvent>& log,
+                                const std::vector<bool>& expectedToEnter, std::string& reason, int& record_number);
+
+// Same result (reason and record_number included), with the sections checked in parallel on pool.
+bool isNetworkSimulationCorrect(const RailwayNetwork& network, const std::vector<RailEvent>& log,
+                                const std::vector<bool>& expectedToEnter, WorkerPool& pool, std::string& reason, int& record_number);
+
+#endif // RAILWAY_NETWORK_H
@@ -0,0 +1,157 @@
+/**
+ * @file TrackLock.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "TrackLock.h"
+#include "Instrumentation.h"
+#include "WorkerPool.h"
+#include <atomic>
+#include <mutex>
+#include <semaphore>
+#include <thread>
+
+bool parse_track_lock_policy(const std::string& name, TrackLockPolicy& policy) {
+    if (name == "mutex") policy = TrackLockPolicy::Mutex;
+    else if (name == "ticket") policy = TrackLockPolicy::Ticket;
+    else if (name == "mcs") policy = TrackLockPolicy::Mcs;
+    else if (name == "semaphore") policy = TrackLockPolicy::Semaphore;
+    else return false;
+    return true;
+}
+
+const char* track_lock_policy_name(TrackLockPolicy policy) {
+    switch (policy) {
+    case TrackLockPolicy::Ticket: return "ticket";
+    case TrackLockPolicy::Mcs: return "mcs";
+    case TrackLockPolicy::Semaphore: return "semaphore";
+    default: return "mutex";
+    }
+}
+
+TrackLock::TrackLock(const char* name, size_t maxHolders)
+    : waitMetric(metric_id(std::string(name) + ".wait")), holdMetric(metric_id(std::string(name) + ".hold")), heldSince(maxHolders, 0) {
+}
+
+void TrackLock::acquire(uint32_t holder) {
+#if TP_INSTRUMENT
+    if (metrics_enabled()) {
+        uint64_t t0 = metrics_now_ns();
+        lockFor(holder);
+        uint64_t t1 = metrics_now_ns();
+        metric_record(waitMetric, t1 - t0);
+        heldSince[holder] = t1;
+        return;
+    }
+#endif
+    lockFor(holder);
+    heldSince[holder] = 0;
+}
+
+void TrackLock::release(uint32_t holder) {
+    uint64_t since = heldSince[holder];
+    unlockFor(holder);
+    if (since != 0) metric_record(holdMetric, metrics_now_ns() - since);
+}
+
+namespace {
+
+class MutexTrackLock : public TrackLock {
+public:
+    using TrackLock::TrackLock;
+
+protected:
+    void lockFor(uint32_t) override { mutex.lock(); }
+    void unlockFor(uint32_t) override { mutex.unlock(); }
+
+private:
+    std::mutex mutex;
+};
+
+// Take a number, wait until it is served. Waiters sleep in atomic::wait instead of spinning,
+// so it also behaves with more trains than cores; a release wakes them all, and all but the
+// next in line go back to sleep.
+class TicketTrackLock : public TrackLock {
+public:
+    using TrackLock::TrackLock;
+
+protected:
+    void lockFor(uint32_t) override {
+        uint32_t ticket = nextTicket.fetch_add(1, std::memory_order_relaxed);
+        for (uint32_t now = nowServing.load(std::memory_order_acquire); now != ticket; now = nowServing.load(std::memory_order_acquire)) {
+            nowServing.wait(now, std::memory_order_acquire);
+        }
+    }
+    void unlockFor(uint32_t) override {
+        nowServing.fetch_add(1, std::memory_order_release);
+        nowServing.notify_all();
+    }
+
+private:
+    alignas(CACHE_LINE_BYTES) std::atomic<uint32_t> nextTicket{ 0 }; // Next number to hand out
+    alignas(CACHE_LINE_BYTES) std::atomic<uint32_t> nowServing{ 0 }; // Number allowed in
+};
+
+// Mellor-Crummey and Scott queue lock. Each holder owns a queue node (indexed by holder, since
+// release happens in another function than acquire); a waiter only watches its own node, and
+// the releasing train hands the lock straight to its successor.
+class McsTrackLock : public TrackLock {
+public:
+    McsTrackLock(const char* name, size_t maxHolders) : TrackLock(name, maxHolders), nodes(new Node[maxHolders]) {}
+
+protected:
+    void lockFor(uint32_t holder) override {
+        Node* me = &nodes[holder];
+        me->next.store(nullptr, std::memory_order_relaxed);
+        me->locked.store(true, std::memory_order_relaxed);
+        Node* predecessor = tail.exchange(me, std::memory_order_acq_rel);
+        if (predecessor == nullptr) return; // Queue was empty
+        predecessor->next.store(me, std::memory_order_release);
+        while (me->locked.load(std::memory_order_acquire)) me->locked.wait(true, std::memory_order_acquire);
+    }
+    void unlockFor(uint32_t holder) override {
+        Node* me = &nodes[holder];
+        Node* successor = me->next.load(std::memory_order_acquire);
+        if (successor == nullptr) {
+            Node* expected = me;
+            if (tail.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel)) return; // Nobody waiting
+            while ((successor = me->next.load(std::memory_order_acquire)) == nullptr) std::this_thread::yield(); // It is linking itself in
+        }
+        successor->locked.store(false, std::memory_order_release);
+        successor->locked.notify_one();
+    }
+
+private:
+    struct alignas(CACHE_LINE_BYTES) Node {
+        std::atomic<Node*> next{ nullptr }; // Train queued behind this one
+        std::atomic<bool> locked{ false }; // True while this train waits
+    };
+    std::unique_ptr<Node[]> nodes; // One per holder
+    alignas(CACHE_LINE_BYTES) std::atomic<Node*> tail{ nullptr }; // Last train in the queue
+};
+
+class SemaphoreTrackLock : public TrackLock {
+public:
+    SemaphoreTrackLock(const char* name, size_t maxHolders, int k) : TrackLock(name, maxHolders), k(k), slots(k) {}
+    int occupancy() const override { return k; }
+
+protected:
+    void lockFor(uint32_t) override { slots.acquire(); }
+    void unlockFor(uint32_t) override { slots.release(); }
+
+private:
+    int k; // Trains allowed in at once
+    std::counting_semaphore<> slots;
+};
+
+}
+
+std::unique_ptr<TrackLock> make_track_lock(TrackLockPolicy policy, size_t maxHolders, int occupancy, const char* name) {
+    switch (policy) {
+    case TrackLockPolicy::Ticket: return std::make_unique<TicketTrackLock>(name, maxHolders);
+    case TrackLockPolicy::Mcs: return std::make_unique<McsTrackLock>(name, maxHolders);
+    case TrackLockPolicy::Semaphore: return std::make_unique<SemaphoreTrackLock>(name, maxHolders, occupancy < 1 ? 1 : occupancy);
+    default: return std::make_unique<MutexTrackLock>(name, maxHolders);
+    }
+}
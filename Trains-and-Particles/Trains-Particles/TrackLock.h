@@ -0,0 +1,56 @@
+/**
+ * @file TrackLock.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef TRACK_LOCK_H
+#define TRACK_LOCK_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// How a shared track section is guarded. A train takes the guard before its first shared cell
+// and gives it back when it leaves, usually from a different function, so the guard is a
+// holder-indexed acquire/release pair rather than a scoped lock.
+//   Mutex      std::mutex: cheap, but no ordering; a busy train can take it again and again
+//   Ticket     FIFO: trains enter in the order they asked
+//   Mcs        FIFO queue lock; every waiter waits on its own node, so a release wakes one train
+//   Semaphore  up to k trains at once (block signalling with k trains per block); k = 1 is a
+//              binary semaphore, also without ordering
+enum class TrackLockPolicy { Mutex, Ticket, Mcs, Semaphore };
+
+// Reads "mutex", "ticket", "mcs" or "semaphore"; false for anything else.
+bool parse_track_lock_policy(const std::string& name, TrackLockPolicy& policy);
+const char* track_lock_policy_name(TrackLockPolicy policy);
+
+// Guard of one shared section for holders 0 .. maxHolders-1 (train indices). Each holder may
+// hold it at most once at a time. Wait and hold times go to the "<name>.wait" and "<name>.hold"
+// metrics, as TimedMutex does.
+class TrackLock {
+public:
+    TrackLock(const char* name, size_t maxHolders);
+    virtual ~TrackLock() = default;
+
+    TrackLock(const TrackLock&) = delete;
+    TrackLock& operator=(const TrackLock&) = delete;
+
+    void acquire(uint32_t holder); // Blocks until holder may enter.
+    void release(uint32_t holder); // Lets the next train in; called by the holder.
+    virtual int occupancy() const { return 1; } // Holders allowed in at once
+
+protected:
+    virtual void lockFor(uint32_t holder) = 0;
+    virtual void unlockFor(uint32_t holder) = 0;
+
+private:
+    int waitMetric, holdMetric; // Ids of "<name>.wait" and "<name>.hold"
+    std::vector<uint64_t> heldSince; // When each holder got in (0 = not timed); only that holder touches its slot
+};
+
+// Guard with the given policy for maxHolders holders; occupancy is k for Semaphore and ignored
+// otherwise.
+std::unique_ptr<TrackLock> make_track_lock(TrackLockPolicy policy, size_t maxHolders, int occupancy = 1, const char* name = "railway.section");
+
+#endif // TRACK_LOCK_H
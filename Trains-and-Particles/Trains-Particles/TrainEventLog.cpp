@@ -0,0 +1,358 @@
+/**
+ * @file TrainEventLog.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "TrainEventLog.h"
+#include "WorkerPool.h"
+#include <cstring>
+#include <filesystem>
+
+static const char EVENT_LOG_MAGIC[8] = { 'T', 'P', 'E', 'V', 'T', '0', '0', '2' };
+const size_t EVENTS_PER_CHUNK = 16384; // Records read per call when streaming a file (384 KiB)
+
+namespace {
+
+// Section state as seen by the train of the record being checked.
+enum SectionState { FREE = 0, MINE = 1, OTHERS = 2 };
+const int KEEP = -1;
+
+// One cell of the transition table: whether the record is allowed and the section's new state.
+// Rejected records are reported as "<train> <action> section <s><condition>", where a condition
+// ending in "while" is followed by "<holder> is on it".
+struct Transition {
+    bool allowed;
+    int next; // FREE, MINE or KEEP
+    const char* action; // e.g. "cannot enter"
+    const char* condition; // e.g. " if it hasn't entered"
+};
+
+// TRANSITIONS[kind][state]; kind 0 = 'E', 1 = 'O', 2 = 'L'
+const Transition TRANSITIONS[3][3] = {
+    { { true, MINE, "", "" }, { false, KEEP, "cannot enter", " while" }, { false, KEEP, "cannot enter", " while" } },
+    { { false, KEEP, "cannot be on", " if it hasn't entered" }, { true, KEEP, "", "" }, { false, KEEP, "cannot be on", " if it hasn't entered" } },
+    { { false, KEEP, "cannot leave", " if it's not on it" }, { true, FREE, "", "" }, { false, KEEP, "cannot leave", " if it's not on it" } },
+};
+
+int kind_index(char kind) {
+    switch (kind) {
+    case 'E': return 0;
+    case 'O': return 1;
+    case 'L': return 2;
+    default: return -1;
+    }
+}
+
+const char* const INVALID_ENTRY = "Not a valid log entry. Have you correctly implemented a mutex?";
+
+std::string train_name(const std::vector<std::string>& names, uint32_t train) {
+    return train < names.size() ? names[train] : "Train " + std::to_string(train);
+}
+
+bool is_valid_record(const RailEvent& e, size_t numTrains, size_t numSections) {
+    return kind_index(e.kind) >= 0 && e.train < numTrains && e.section < numSections;
+}
+
+std::string out_of_order(uint64_t sequence, uint64_t previous) {
+    return "Log records are out of order (sequence " + std::to_string(sequence) + " after " + std::to_string(previous) + ")";
+}
+
+// Applies a valid record to the train on its section (on, -1 when free). Returns false, with
+// why, when the transition table rejects it.
+bool apply_record(int32_t& on, const RailEvent& e, const std::vector<std::string>& names, std::string& why) {
+    int kind = kind_index(e.kind);
+    int state = on == -1 ? FREE : (on == static_cast<int32_t>(e.train) ? MINE : OTHERS);
+    const Transition& t = TRANSITIONS[kind][state];
+    if (!t.allowed) {
+        why = train_name(names, e.train) + " " + t.action + " section " + std::to_string(e.section) + t.condition;
+        if (kind == 0) why += " " + train_name(names, static_cast<uint32_t>(on)) + " is on it";
+        return false;
+    }
+    if (t.next == MINE) on = static_cast<int32_t>(e.train);
+    else if (t.next == FREE) on = -1;
+    return true;
+}
+
+} // namespace
+
+static std::atomic<uint64_t> nextRecorderInstance{ 1 };
+
+EventRecorder::EventRecorder()
+    : instance(nextRecorderInstance.fetch_add(1)), generation(0), nextSequence(0), start(std::chrono::steady_clock::now()) {
+}
+
+EventRecorder::Buffer& EventRecorder::localBuffer() {
+    // Per-thread cache of the last buffer used; only a thread's first event of a run takes the mutex.
+    struct Cache {
+        uint64_t instance = 0;
+        uint64_t generation = 0;
+        Buffer* buffer = nullptr;
+    };
+    thread_local Cache cache;
+    uint64_t current = generation.load(std::memory_order_acquire);
+    if (cache.instance != instance || cache.generation != current || cache.buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        buffers.emplace_back();
+        buffers.back().events.reserve(1024);
+        cache = { instance, current, &buffers.back() };
+    }
+    return *cache.buffer;
+}
+
+void EventRecorder::record(uint32_t train, uint16_t section, char kind) {
+    Buffer& buffer = localBuffer();
+    // Relaxed is enough: all increments of one atomic have a single modification order, and it
+    // agrees with the happens-before order the section lock creates between the recording threads.
+    uint64_t sequence = nextSequence.fetch_add(1, std::memory_order_relaxed);
+    uint64_t timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    buffer.events.push_back({ sequence, timestamp, train, section, kind, 0 });
+}
+
+void EventRecorder::reset() {
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffers.clear();
+    nextSequence.store(0);
+    start = std::chrono::steady_clock::now();
+    generation.fetch_add(1, std::memory_order_release);
+}
+
+std::vector<RailEvent> EventRecorder::merge() const {
+    // Sequence numbers are dense (one per recorded event), so each event goes straight to its slot.
+    std::vector<RailEvent> merged(nextSequence.load());
+    for (const Buffer& buffer : buffers) {
+        for (const RailEvent& e : buffer.events) {
+            if (e.sequence < merged.size()) merged[e.sequence] = e;
+        }
+    }
+    return merged;
+}
+
+StreamingTrainValidator::StreamingTrainValidator(size_t numTrains, size_t numSections, const std::vector<std::string>& names,
+                                                 const std::vector<bool>& expectedToEnter)
+    : names(names), expected(expectedToEnter), occupant(numSections, -1), entered(numTrains, false),
+      records(0), lastRecord(0), lastSequence(0), valid(true) {
+}
+
+bool StreamingTrainValidator::fail(const std::string& why) {
+    valid = false;
+    failure = why;
+    return false;
+}
+
+bool StreamingTrainValidator::consume(const RailEvent& e) {
+    if (!valid) return false;
+    lastRecord = records++; // Record the current log entry number
+
+    if (!is_valid_record(e, entered.size(), occupant.size())) return fail(INVALID_ENTRY);
+    if (lastRecord > 0 && e.sequence <= lastSequence) return fail(out_of_order(e.sequence, lastSequence));
+    lastSequence = e.sequence;
+
+    std::string why;
+    if (!apply_record(occupant[e.section], e, names, why)) return fail(why);
+    if (e.kind == 'E') entered[e.train] = true; // The train has moved
+    return true;
+}
+
+bool StreamingTrainValidator::consume(const RailEvent* events, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (!consume(events[i])) return false;
+    }
+    return valid;
+}
+
+bool StreamingTrainValidator::finish() {
+    if (!valid) return false;
+    for (size_t t = 0; t < entered.size(); t++) {
+        if (t < expected.size() && expected[t] && !entered[t]) {
+            return fail("The " + train_name(names, static_cast<uint32_t>(t)) + " thread does not seem to work correctly.");
+        }
+    }
+    return true;
+}
+
+namespace {
+
+// First violation found by one worker: lowest record index, then the check a sequential pass
+// would make first at that record (entry and order checks before the section's state machine).
+struct Violation {
+    uint64_t record = UINT64_MAX;
+    int check = 0; // 0 = entry/order check, 1 = section state machine
+    std::string why;
+
+    void offer(uint64_t r, int c, const std::string& w) {
+        if (r < record || (r == record && c < check)) {
+            record = r;
+            check = c;
+            why = w;
+        }
+    }
+};
+
+} // namespace
+
+bool validate_events_parallel(const std::vector<RailEvent>& log, size_t numTrains, size_t numSections,
+                              const std::vector<std::string>& names, const std::vector<bool>& expectedToEnter,
+                              WorkerPool& pool, std::string& reason, int& record_number) {
+    const size_t numWorkers = pool.size();
+    std::vector<Violation> found(numWorkers);
+    std::vector<std::vector<uint32_t>> workerCounts(numWorkers); // Per-worker section histograms, then write positions
+    std::vector<std::vector<char>> workerEntered(numWorkers); // Per-worker "has entered" flags (by train)
+
+    // Pass 1 (parallel, by record chunk): entry and order checks, entered flags, section histogram
+    pool.runIndexedStep(log.size(), [&](size_t worker, size_t start, size_t end) {
+        std::vector<uint32_t>& counts = workerCounts[worker];
+        std::vector<char>& entered = workerEntered[worker];
+        counts.assign(numSections, 0);
+        entered.assign(numTrains, 0);
+        for (size_t i = start; i < end; i++) {
+            const RailEvent& e = log[i];
+            if (!is_valid_record(e, numTrains, numSections)) {
+                found[worker].offer(i, 0, INVALID_ENTRY);
+                break; // Nothing later in this chunk can be earlier
+            }
+            if (i > 0 && e.sequence <= log[i - 1].sequence) {
+                found[worker].offer(i, 0, out_of_order(e.sequence, log[i - 1].sequence));
+                break;
+            }
+            counts[e.section]++;
+            if (e.kind == 'E') entered[e.train] = 1;
+        }
+    });
+
+    // Pass 2 (serial): section-major prefix sum, as in SpatialGrid::build
+    std::vector<uint32_t> sectionStart(numSections + 1);
+    uint32_t offset = 0;
+    for (size_t s = 0; s < numSections; s++) {
+        sectionStart[s] = offset;
+        for (size_t w = 0; w < numWorkers; w++) {
+            if (workerCounts[w].empty()) continue; // Worker had an empty range
+            uint32_t n = workerCounts[w][s];
+            workerCounts[w][s] = offset;
+            offset += n;
+        }
+    }
+    sectionStart[numSections] = offset;
+
+    // Pass 3 (parallel): scatter record indices; inside a section they stay in log order
+    std::vector<uint32_t> bySection(offset);
+    pool.runIndexedStep(log.size(), [&](size_t worker, size_t start, size_t end) {
+        std::vector<uint32_t>& next = workerCounts[worker];
+        for (size_t i = start; i < end; i++) {
+            const RailEvent& e = log[i];
+            if (!is_valid_record(e, numTrains, numSections) || (i > 0 && e.sequence <= log[i - 1].sequence)) break; // Same stop as pass 1
+            bySection[next[e.section]++] = static_cast<uint32_t>(i);
+        }
+    });
+
+    // Pass 4 (parallel, by section): run each section's state machine up to its first violation.
+    // Busy sections have far more records than quiet ones, so sections are work-stolen one at a time
+    pool.runStealingStep(numSections, [&](size_t worker, size_t start, size_t end) {
+        std::string why;
+        for (size_t s = start; s < end; s++) {
+            int32_t on = -1;
+            for (uint32_t k = sectionStart[s]; k < sectionStart[s + 1]; k++) {
+                uint32_t i = bySection[k];
+                if (i >= found[worker].record) break; // Cannot beat this worker's earliest violation
+                if (!apply_record(on, log[i], names, why)) {
+                    found[worker].offer(i, 1, why);
+                    break;
+                }
+            }
+        }
+    }, 1);
+
+    Violation first;
+    for (const Violation& v : found) {
+        if (v.record != UINT64_MAX) first.offer(v.record, v.check, v.why);
+    }
+    if (first.record != UINT64_MAX) {
+        reason = first.why;
+        record_number = static_cast<int>(first.record);
+        return false;
+    }
+
+    record_number = log.empty() ? 0 : static_cast<int>(log.size() - 1); // The sequential pass ends on the last record
+    for (size_t t = 0; t < numTrains; t++) {
+        if (t >= expectedToEnter.size() || !expectedToEnter[t]) continue;
+        bool entered = false;
+        for (size_t w = 0; w < numWorkers && !entered; w++) {
+            entered = !workerEntered[w].empty() && workerEntered[w][t];
+        }
+        if (!entered) {
+            reason = "The " + train_name(names, static_cast<uint32_t>(t)) + " thread does not seem to work correctly.";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool EventLogWriter::open(const std::string& path, uint32_t numTrains, uint32_t numSections, const std::vector<bool>& expectedToEnter,
+                          std::string& reason) {
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        reason = "Cannot create event log " + path;
+        return false;
+    }
+    file.write(EVENT_LOG_MAGIC, sizeof(EVENT_LOG_MAGIC));
+    file.write(reinterpret_cast<const char*>(&numTrains), sizeof(numTrains));
+    file.write(reinterpret_cast<const char*>(&numSections), sizeof(numSections));
+    std::vector<char> expected(numTrains, 0);
+    for (size_t t = 0; t < numTrains && t < expectedToEnter.size(); t++) expected[t] = expectedToEnter[t] ? 1 : 0;
+    file.write(expected.data(), static_cast<std::streamsize>(expected.size()));
+    return true;
+}
+
+void EventLogWriter::write(const RailEvent* events, size_t count) {
+    file.write(reinterpret_cast<const char*>(events), static_cast<std::streamsize>(count * sizeof(RailEvent)));
+}
+
+void EventLogWriter::close() {
+    if (file.is_open()) file.close();
+}
+
+bool validate_event_log_file(const std::string& path, std::string& reason, int& record_number, uint64_t& recordsChecked) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[8];
+    uint32_t numTrains = 0, numSections = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&numTrains), sizeof(numTrains));
+    in.read(reinterpret_cast<char*>(&numSections), sizeof(numSections));
+    record_number = 0;
+    recordsChecked = 0;
+    if (!in || std::memcmp(magic, EVENT_LOG_MAGIC, sizeof(magic)) != 0) {
+        reason = "Cannot read event log " + path;
+        return false;
+    }
+    std::error_code ec;
+    uint64_t fileSize = std::filesystem::file_size(path, ec);
+    uint64_t headerSize = sizeof(magic) + sizeof(numTrains) + sizeof(numSections) + uint64_t(numTrains);
+    if (ec || fileSize < headerSize) {
+        reason = "Event log " + path + " has a truncated header";
+        return false;
+    }
+    if ((fileSize - headerSize) % sizeof(RailEvent) != 0) { // Checked up front: the stream below must not stop early
+        reason = "Event log " + path + " ends in a partial record";
+        record_number = static_cast<int>((fileSize - headerSize) / sizeof(RailEvent));
+        return false;
+    }
+    std::vector<char> flags(numTrains);
+    in.read(flags.data(), static_cast<std::streamsize>(flags.size()));
+    std::vector<bool> expectedToEnter(flags.begin(), flags.end());
+
+    StreamingTrainValidator validator(numTrains, numSections, {}, expectedToEnter);
+    std::vector<RailEvent> chunk(EVENTS_PER_CHUNK); // The only buffer, whatever the file size
+    while (validator.ok()) {
+        in.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(chunk.size() * sizeof(RailEvent)));
+        size_t count = static_cast<size_t>(in.gcount()) / sizeof(RailEvent);
+        if (count == 0) break;
+        validator.consume(chunk.data(), count);
+    }
+    validator.finish();
+
+    recordsChecked = validator.recordsChecked();
+    record_number = validator.recordNumber();
+    reason = validator.reason();
+    return validator.ok();
+}
@@ -0,0 +1,119 @@
+/**
+ * @file TrainEventLog.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef TRAIN_EVENT_LOG_H
+#define TRAIN_EVENT_LOG_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+
+// Compact, fixed-size (24 byte) encoding of one trains_log entry, for any number of trains and
+// sections. kind is 'E' (entering), 'O' (on the section) or 'L' (has left), as in "Train A- E".
+struct RailEvent {
+    uint64_t sequence; // Position in the global order of the log
+    uint64_t timestamp; // Nanoseconds since the start of the run (virtual ticks in discrete-event runs)
+    uint32_t train; // Index of the train
+    uint16_t section; // Index of the shared section
+    char kind; // 'E', 'O' or 'L'
+    uint8_t reserved; // Padding, always 0
+};
+
+// Records events from many threads without a shared lock on the hot path. Each thread appends
+// to its own buffer; the global order comes from one atomic sequence counter. Call record()
+// while holding the lock that guards the section (after acquiring it for 'E', before releasing
+// it for 'L'): the counter's modification order then follows the order in which the lock was
+// taken, so a mutual-exclusion violation still shows up as overlapping records after merge().
+class EventRecorder {
+public:
+    EventRecorder();
+
+    void record(uint32_t train, uint16_t section, char kind); // Appends a stamped event to the calling thread's buffer.
+    void reset(); // Drops all events and restarts sequence and timestamps. No thread may be recording.
+    std::vector<RailEvent> merge() const; // All events in sequence order. No thread may be recording.
+
+private:
+    struct Buffer {
+        std::vector<RailEvent> events;
+    };
+    Buffer& localBuffer(); // The calling thread's buffer for the current run, registered on first use
+
+    const uint64_t instance; // Distinguishes recorders in the per-thread buffer cache
+    std::atomic<uint64_t> generation; // Bumped by reset() so threads register a fresh buffer
+    std::atomic<uint64_t> nextSequence; // Global order of events
+    std::chrono::steady_clock::time_point start; // Origin of timestamps
+    std::mutex buffersMutex; // Taken once per thread and run, to register its buffer
+    std::deque<Buffer> buffers; // One per recording thread (deque: addresses stay valid)
+};
+
+// Table-driven validator that consumes a log one record at a time, using memory proportional
+// to the number of trains and sections only, so logs of any length can be checked as a stream.
+// It applies the rules of isSimulationCorrect to every section independently: a train may only
+// enter a free section, may only be on or leave a section it entered; sequence numbers must
+// increase; and, at the end, every train flagged in expectedToEnter must have entered.
+class StreamingTrainValidator {
+public:
+    // names: train names for messages ("Train <id>" when empty or too short).
+    StreamingTrainValidator(size_t numTrains, size_t numSections, const std::vector<std::string>& names = {},
+                            const std::vector<bool>& expectedToEnter = {});
+
+    bool consume(const RailEvent& e); // Checks one record; false (and stays false) after the first violation.
+    bool consume(const RailEvent* events, size_t count); // Checks a batch of records.
+    bool finish(); // End-of-log checks (every expected train has moved).
+
+    bool ok() const { return valid; }
+    const std::string& reason() const { return failure; } // Why validation failed
+    int recordNumber() const { return static_cast<int>(lastRecord); } // Record that failed (as record_number)
+    uint64_t recordsChecked() const { return records; }
+
+private:
+    bool fail(const std::string& why); // Records the first violation
+
+    std::vector<std::string> names; // Train names
+    std::vector<bool> expected; // Trains that must have entered by the end
+    std::vector<int32_t> occupant; // Train on each section, -1 when free
+    std::vector<bool> entered; // Flags to check that each train has moved
+    uint64_t records; // Records consumed so far
+    uint64_t lastRecord; // Index of the last record consumed
+    uint64_t lastSequence; // Sequence number of the last record
+    bool valid; // False after the first violation
+    std::string failure; // Reason of the first violation
+};
+
+class WorkerPool;
+
+// Parallel equivalent of a StreamingTrainValidator over a whole in-memory log. Records are
+// bucketed by section with a counting sort and every section's state machine runs on its own;
+// record checks, the sequence order and per-train "has moved" flags are computed over
+// contiguous chunks. Sections are independent, so the earliest violation over all partitions is
+// the record a sequential pass would stop at: reason and record_number match it exactly.
+bool validate_events_parallel(const std::vector<RailEvent>& log, size_t numTrains, size_t numSections,
+                              const std::vector<std::string>& names, const std::vector<bool>& expectedToEnter,
+                              WorkerPool& pool, std::string& reason, int& record_number);
+
+// Binary event log file: char[8] "TPEVT002", uint32 trains, uint32 sections, one uint8 per train
+// (1 if it was expected to enter a section), then RailEvent records.
+class EventLogWriter {
+public:
+    bool open(const std::string& path, uint32_t numTrains, uint32_t numSections, const std::vector<bool>& expectedToEnter,
+              std::string& reason);
+    void write(const RailEvent* events, size_t count); // Appends records
+    void close();
+
+private:
+    std::ofstream file;
+};
+
+// Streams an event log file through a StreamingTrainValidator in fixed-size chunks, with the
+// expected trains stored in the header. Returns false with reason/record_number on the first
+// violation, or if the file is unreadable or ends in a partial record.
+bool validate_event_log_file(const std::string& path, std::string& reason, int& record_number, uint64_t& recordsChecked);
+
+#endif // TRAIN_EVENT_LOG_H
@@ -7,86 +7,126 @@
  */
 
 #include "Trains_and_Particles.h"
+#include "WorkerPool.h"
+#include "ParticleSoA.h"
+#include "ParticleBenchmark.h"
+#include "ParticleCollisions.h"
+#include "ParticlePipeline.h"
+#include "ParticleRng.h"
+#include "ParticleKernels.h"
+#include "FrameRenderer.h"
+#include "AsyncLogger.h"
+#include "Gate.h"
 #include <random>
 #include <iostream>
 #include <thread>
 #include <chrono>
-#include <fstream>
 #include <mutex>
+#include <cstdlib>
 
- //global variables for logging
-std::once_flag log_init_flag;
-std::ofstream log_file;
+//-----------------------------------------------------------Part 1: Trains ------------------------------------------------------------------//
 
-//log function
-void initialize_logging()
-{
-    log_file.open("app.log"); // Open a file for logging.
-    log_file << "Logging initialized." << std::endl;
+// Constructor: Initializes positions of the trains and the shared track section boundaries.
+RailwaySystem::RailwaySystem(TrackLockPolicy policy) : positionA(0), positionB(0), positionC(0), sharedSectionStart(10), sharedSectionEnd(15),
+    trainNames{ "Train A", "Train B" } {
+    sharedTrackLock = make_track_lock(policy, trainNames.size(), 1, "railway.shared_track");
 }
 
+// Destructor: Stops and joins any train thread still running.
+RailwaySystem::~RailwaySystem() {
+    stop();
+    joinTrains();
+}
 
-// Function that logs messages.
-// It ensures that the logging is initialized before any message is logged.
-void log(const std::string& message) {
-    std::call_once(log_init_flag, initialize_logging); // Ensure initialization happens only once.
-    log_file << message << std::endl; // Write the message to the log file.
+void RailwaySystem::stop() {
+    std::lock_guard<std::mutex> lock(lifecycleMutex);
+    stopSource.request_stop(); // Trains finish their current move and leave the shared track if they are on it
+    gateC.shutdown(); // Releases trainC if it is waiting for the gate
 }
 
-//-----------------------------------------------------------Part 1: Trains ------------------------------------------------------------------//
+void RailwaySystem::joinTrains() {
+    for (std::jthread* thread : { &threadA, &threadB, &threadC }) {
+        if (thread->joinable()) thread->join();
+    }
+}
 
-// Constructor: Initializes positions of the trains and the shared track section boundaries.
-RailwaySystem::RailwaySystem() : positionA(0), positionB(0), positionC(0), canMoveC(false), sharedSectionStart(10), sharedSectionEnd(15) {
+uint32_t RailwaySystem::trainIndex(const std::string& trainName) const {
+    for (uint32_t t = 0; t < trainNames.size(); t++) {
+        if (trainNames[t] == trainName) return t;
+    }
+    return static_cast<uint32_t>(trainNames.size()); // Unknown train: rejected by the validators
 }
 
-void RailwaySystem::trainC() 
+// Sleeps for duration unless stop is requested first (it then returns at once). Every train and
+// the display loop share one long-lived mutex/condition pair, so a step costs no construction.
+bool RailwaySystem::sleepUnlessStopped(const std::stop_token& stop, std::chrono::milliseconds duration) {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    sleepWake.wait_for(lock, stop, duration, [] { return false; });
+    return !stop.stop_requested();
+}
+
+void RailwaySystem::trainC(std::stop_token stop) 
 {
-    while (true) 
+    while (gateC.wait()) // Wait until Train A opens the gate; false once the simulation stops
     {
-        std::unique_lock<std::mutex> lock(mtxC);
-        cvC.wait(lock, [this] { return canMoveC; }); // Wait until canMoveC is true
         // Movement logic for trainC
         log("Train C position: " + std::to_string(positionC));
         positionC = (positionC + 1) % 25;
-        lock.unlock();
-        std::this_thread::sleep_for(std::chrono::seconds(1)); // Simulate time taken for each step
+        if (!sleepUnlessStopped(stop, std::chrono::seconds(1))) break; // Simulate time taken for each step
     }
 }
 
 // Starts the simulation by launching threads for Train A and Train B.
 void RailwaySystem::startSimulation(int numSteps) {
     simulationSteps = numSteps;
+    recorder.reset();
+    positionA = positionB = positionC = 0;
+    std::stop_token token;
+    {
+        std::lock_guard<std::mutex> lock(lifecycleMutex);
+        stopSource = std::stop_source(); // Fresh stop state and gate, so a RailwaySystem can run again
+        gateC.reset();
+        token = stopSource.get_token();
+    }
 
     //Todo: Task 1 
-    std::thread threadA(&RailwaySystem::trainA, this); // Creates and starts a thread for Train A (Read Note1 in the labsheet).
-    std::thread threadB(&RailwaySystem::trainB, this); // Creates and starts a thread for Train B.
-    std::thread threadC(&RailwaySystem::trainC, this); // Creates and starts a thread for Train C.
-
-    threadA.detach(); // Detaches threadA to run independently.
-    threadB.detach(); // Detaches threadB to run independently.
-    threadC.detach(); // Detaches threadC to run independently.
+    threadA = std::jthread(&RailwaySystem::trainA, this, token); // Creates and starts a thread for Train A (Read Note1 in the labsheet).
+    threadB = std::jthread(&RailwaySystem::trainB, this, token); // Creates and starts a thread for Train B.
+    threadC = std::jthread(&RailwaySystem::trainC, this, token); // Creates and starts a thread for Train C.
 
     for (int step = 0; step < simulationSteps; step++) // Within a loop limited by simulationSteps, perform the following:
     {
         displayTracks(); // Continuously updates and displays the current state of the tracks. Call the displayTracks() function
-        std::this_thread::sleep_for(std::chrono::milliseconds(500)); // Pauses the loop for a short duration. (Read Note2 in the labsheet).
+        if (!sleepUnlessStopped(token, std::chrono::milliseconds(500))) break; // Pauses the loop for a short duration. (Read Note2 in the labsheet).
+    }
+
+    // Trains A and B finish their steps; then Train C is stopped, and no thread outlives the run.
+    threadA.join();
+    threadB.join();
+    stop();
+    joinTrains();
+
+    // Trains A and B recorded into their own buffers; merge them into trains_log.
+    for (const RailEvent& e : recorder.merge()) {
+        std::string name = e.train < trainNames.size() ? trainNames[e.train] : "Train ?";
+        trains_log.push_back(name + "- " + e.kind);
     }
 }
 
 // Simulates the behavior of Train A.
-void RailwaySystem::trainA() {
+void RailwaySystem::trainA(std::stop_token stop) {
     int step = 0;
+    bool onTrack = false; // Holds the shared track (between entering and leaving)
 
-    while (step < simulationSteps / 2) {
+    while (step < simulationSteps / 2 && !stop.stop_requested()) {
         step++;
         // Log the position of Train A at each step
         log("Train A position: " + std::to_string(positionA));
 
         if (positionA == sharedSectionStart - 1) {
             enterSharedTrack("Train A"); // Train A prepares to enter the shared track.
-            std::lock_guard<std::mutex> lock(mtxC);
-            canMoveC = true; // Signal trainC to start
-            cvC.notify_one();
+            onTrack = true;
+            gateC.open(); // Signal trainC to start
         }
 
         if (positionA >= sharedSectionStart && positionA <= sharedSectionEnd) {
@@ -95,26 +135,33 @@ void RailwaySystem::trainA() {
 
         if (positionA == sharedSectionEnd) {
             leaveSharedTrack("Train A"); // Train A leaves the shared track.
+            onTrack = false;
         }
 
         positionA = (positionA + 1) % 25; // Moves Train A forward and loops around the track.
-        std::this_thread::sleep_for(std::chrono::seconds(1)); // Waits before the next movement.
+        sleepUnlessStopped(stop, std::chrono::seconds(1)); // Waits before the next movement.
+    }
+
+    if (onTrack) {
+        leaveSharedTrack("Train A"); // Stopped on the shared track: free it so Train B can finish too.
     }
 }
 
 // Simulates the behavior of Train B.
-void RailwaySystem::trainB() {
+void RailwaySystem::trainB(std::stop_token stop) {
     // Todo: Task 2
         // Implement this function in a manner very similar to the trainA function.
     int step = 0;
+    bool onTrack = false; // Holds the shared track (between entering and leaving)
 
-    while (step < simulationSteps / 2) {
+    while (step < simulationSteps / 2 && !stop.stop_requested()) {
         step++;
         // Log the position of Train B at each step
         log("Train B position: " + std::to_string(positionB));
 
         if (positionB == sharedSectionStart - 1) {
             enterSharedTrack("Train B"); // Train B prepares to enter the shared track.
+            onTrack = true;
         }
 
         if (positionB >= sharedSectionStart && positionB <= sharedSectionEnd) {
@@ -123,23 +170,27 @@ void RailwaySystem::trainB() {
 
         if (positionB == sharedSectionEnd) {
             leaveSharedTrack("Train B"); // Train B leaves the shared track.
-            std::lock_guard<std::mutex> lock(mtxC);
-            canMoveC = false; // Signal trainC to stop
-            cvC.notify_one();
+            onTrack = false;
+            gateC.close(); // Signal trainC to stop
         }
 
         positionB = (positionB + 1) % 25; // Moves Train B forward and loops around the track.
-        std::this_thread::sleep_for(std::chrono::seconds(1)); // Waits before the next movement.
+        sleepUnlessStopped(stop, std::chrono::seconds(1)); // Waits before the next movement.
+    }
+
+    if (onTrack) {
+        leaveSharedTrack("Train B"); // Stopped on the shared track: free it so Train A can finish too.
+        gateC.close();
     }
 }
 
 // Manages a train entering the shared track section.
 void RailwaySystem::enterSharedTrack(const std::string& trainName) {
 
-    sharedTrackMutex.lock(); // Locks the mutex to ensure exclusive access to the shared track.
+    sharedTrackLock->acquire(trainIndex(trainName)); // Takes the guard to ensure exclusive access to the shared track.
     std::cout << trainName << " is entering the shared track." << std::endl; // Outputs a message (e.g. "Train A is entering the shared track.") indicating the given train is entering the shared track.
     log(trainName + " is entering the shared track."); // Log this event
-    trains_log.push_back(trainName + "- E"); // Update the trains_log (see the trains_log description in the header file)
+    recorder.record(trainIndex(trainName), 0, 'E'); // Update the trains_log (merged into it at the end of startSimulation)
 
 }
 
@@ -150,21 +201,22 @@ void RailwaySystem::onSharedTrack(const std::string& trainName) {
     // For example, if 'trainName' is "Train A", the log entry will be "Train A- O".
     std::cout << trainName << " is on the shared track." << std::endl; // Outputs a message (e.g. "Train B is on the shared track.") indicating the given train is on the shared track.
     log(trainName + " is on the shared track."); // Log this event
-    trains_log.push_back(trainName + "- O");
+    recorder.record(trainIndex(trainName), 0, 'O');
 }
 
 // Manages a train leaving the shared track section.
 void RailwaySystem::leaveSharedTrack(const std::string& trainName) {
     //Todo: Task3 
-    trains_log.push_back(trainName + "- L"); // Update the trains_log (see the trains_log description in the header file)
+    recorder.record(trainIndex(trainName), 0, 'L'); // Update the trains_log (merged into it at the end of startSimulation)
     std::cout << trainName << " has left the shared track." << std::endl; // Outputs a message (e.g. "Train B has left the shared track.") indicating the given train has left the shared track.
     log(trainName + " has left the shared track."); // Log this event
-    sharedTrackMutex.unlock(); // Unlocks the mutex, allowing the other train to access the shared track.
+    sharedTrackLock->release(trainIndex(trainName)); // Releases the guard, allowing the other train to access the shared track.
 
 }
 
 // Displays the current state of the tracks and trains.
 void RailwaySystem::displayTracks() {
+    TP_SCOPED_TIMER("railway.display");
     std::cout << "Displaying current tracks state..." << std::endl; // Example display message
     log("Displaying current tracks state..."); // Log this event for record-keeping
     std::cout << "\x1B[2J\x1B[H"; // Clears the screen for fresh display of tracks.
@@ -207,8 +259,8 @@ void RailwaySystem::displayTracks() {
 
 
 // Implementation of the Particle class constructor
-Particle::Particle(int id) : x(0), y(0), vx(0), vy(0), id(id), wallHits(0) {
-    // Initializes a particle with a unique ID and zero initial position, velocity, and wall hits.
+Particle::Particle(int id) : x(0), y(0), vx(0), vy(0), id(id), wallHits(0), collisions(0) {
+    // Initializes a particle with a unique ID and zero initial position, velocity, wall hits and collisions.
 }
 
 // Updates the position of a particle based on its velocity and checks for boundary collisions
@@ -217,14 +269,9 @@ void Particle::update(float dt) {
     y += vy * dt; // Update the y-coordinate of the particle's position
 
     // Check for boundary collisions and reverse velocity if a collision occurs
-    if (x <= -10 || x >= 10) {
-        vx *= -1; // Reverse the x-velocity
-        wallHits++; // Increment the wall hit count
-    }
-    if (y <= -10 || y >= 10) {
-        vy *= -1; // Reverse the y-velocity
-        wallHits++; // Increment the wall hit count
-    }
+    // (the 2D float case of the reflecting policy in ParticleKernels.h)
+    ReflectBoundary::axis(x, vx, wallHits);
+    ReflectBoundary::axis(y, vy, wallHits);
 }
 
 // Initializes particles with random positions and velocities
@@ -232,7 +279,12 @@ void initialize_particles(std::vector<Particle>& particles) {
     //std::random_device rd; // Random number generator
     //std::mt19937 gen(rd()); // Mersenne Twister generator. I replaced this with the line below (including a fixed seed value) for the purpose of reproducibility
     std::mt19937 gen(12345); // Fixed seed value ensures reproducibility
+    initialize_particles(particles, gen);
+}
 
+// Initializes particles from the given generator, leaving it in the state after the last draw
+// (so the state can be saved in a checkpoint and a resumed run continues the same sequence).
+void initialize_particles(std::vector<Particle>& particles, std::mt19937& gen) {
     std::uniform_real_distribution<> dis(-10.0, 10.0); // Distribution for position and velocity
 
     for (auto& p : particles) {
@@ -250,103 +302,235 @@ void update_particles(std::vector<Particle>& particles, float dt, size_t start,
     }
 }
 
-// Visualizes particles on a 2D grid in the console
-void visualize_particles(const std::vector<Particle>& particles, int width, int height) {
-    std::vector<std::string> grid(width * height, " "); // Create a blank grid
-
-    // Create the visual representation of the walls
-    for (int x = 0; x < width; ++x) {
-        grid[x] = "-"; // Top wall
-        grid[x + (height - 1) * width] = "-"; // Bottom wall
-    }
-    for (int y = 0; y < height; ++y) {
-        grid[y * width] = "|"; // Left wall
-        grid[(y + 1) * width - 1] = "|"; // Right wall
-    }
-
-    // Plot each particle on the grid
-    for (const auto& p : particles) {
-        int x = static_cast<int>((p.x + 10) / 20 * (width - 2)) + 1;
-        int y = static_cast<int>((p.y + 10) / 20 * (height - 2)) + 1;
-        if (x > 0 && x < width - 1 && y > 0 && y < height - 1) {
-            std::string color; // Color code for the particle based on the number of wall hits
-            // Assign color based on wall hit count
-            if (p.wallHits < 3) color = "\033[37m"; // White for fewer than 3 hits
-            else if (p.wallHits < 5) color = "\033[32m"; // Green for 3-4 hits
-            else if (p.wallHits < 7) color = "\033[33m"; // Yellow for 5-6 hits
-            else color = "\033[31m"; // Red for 7 or more hits
-
-            grid[x + y * width] = color + std::to_string(p.id) + "\033[0m"; // Set the particle's position on the grid with color and ID
-        }
+// Updates a range of particles and counts the wall hits of this step in a local, so the caller
+// can add them to a per-worker total instead of summing every particle's counter.
+int update_particles_counted(std::vector<Particle>& particles, float dt, size_t start, size_t end) {
+    int hits = 0;
+    for (size_t i = start; i < end; ++i) {
+        int before = particles[i].wallHits;
+        particles[i].update(dt);
+        hits += particles[i].wallHits - before;
     }
+    return hits;
+}
 
-    // Draw the grid to the console
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            std::cout << grid[x + y * width]; // Print each cell of the grid
-        }
-        std::cout << std::endl; // New line at the end of each row
-    }
+// Visualizes particles on a 2D grid in the console.
+// The FrameRenderer keeps its buffers between calls, so steady-state frames do not allocate.
+// Not for concurrent use from several threads (one renderer is shared by all calls).
+void visualize_particles(const std::vector<Particle>& particles, int width, int height) {
+    static FrameRenderer renderer(width, height);
+    TP_SCOPED_TIMER("render.frame");
+    renderer.resize(width, height); // No-op unless the grid size changed
+    renderer.draw(particles, false);
 }
 
-// Manages the parallel movement of particles in the simulation
+// Manages the parallel movement of particles in the simulation.
+// Runs as a pipeline: the workers compute step N+1 while a stats thread reduces step N and a
+// render thread draws an earlier step, each on its own snapshot of the particles.
 std::vector<Particle> parallel_moving_particles() {
-    std::vector<Particle> pars;
-    std::cout << " You need to implement the parallel_moving_particles() method before testing it.\n\n";
-    //Todo Task 4
     std::vector<Particle> particles(NUM_PARTICLES); // Container for particles
-    std::vector<std::thread> threads(NUM_THREADS); // Container for threads
+    WorkerPool pool(NUM_THREADS); // Worker threads are started once and reused for every step
 
     for (int i = 0; i < NUM_PARTICLES; i++) // Initialize particles with unique IDs
     {
         particles[i] = Particle(i); // Add new particles to the vector
     }
 
-    initialize_particles(particles); // Initialize particles with random positions and velocities
+    initialize_particles_parallel(particles, pool); // Initialize particles with random positions and velocities (same values as initialize_particles)
+
+    PipelineOptions options;
+    options.framePace = std::chrono::milliseconds(100); // Each frame stays on screen for a short time
+    PipelineResult result = run_particle_pipeline(particles, NUM_STEPS, DT, COLLISION_RADIUS, pool, options);
+    return result.particles; // return the particles
+}
 
-    for (int step = 0; step < NUM_STEPS; step++) // Run the simulation for a set number of steps
+// Runs one step by creating and joining a fresh thread per range (the original Task 4 approach).
+// Kept as the baseline for benchmark_step_throughput().
+void spawn_per_step_update(std::vector<Particle>& particles, float dt, size_t numThreads) {
+    TP_SCOPED_TIMER("particles.spawn_join");
+    std::vector<std::thread> threads(numThreads); // Container for threads
+    for (size_t i = 0; i < numThreads; i++) // Launch threads to update particles in parallel
     {
-        int step_size = NUM_PARTICLES / NUM_THREADS; // Calculate the number of particles each thread should handle
+        size_t start, end;
+        partition_range(i, numThreads, particles.size(), start, end);
+        threads[i] = std::thread(update_particles, std::ref(particles), dt, start, end);
+    }
+    for (auto& t : threads) // Join threads after their completion
+    {
+        if (t.joinable()) t.join();
+    }
+}
 
-        for (int i = 0; i < NUM_THREADS; i++) // Launch threads to update particles in parallel
-        {
-            int start = i * step_size; // Determine the start index for each thread
-            int end = (i + 1) * step_size; // Determine the end index for each thread
+// Compares steps per second of the spawn-per-step path against the persistent WorkerPool.
+// No rendering or sleeping is done, so only the update and the thread overheads are measured.
+// Both paths start from the same initial state and must end with the same total wall hits.
+void benchmark_step_throughput(const ParticleSimConfig& config) {
+    std::vector<Particle> initial(config.numParticles);
+    for (size_t i = 0; i < config.numParticles; i++) initial[i] = Particle(static_cast<int>(i));
+    initialize_particles(initial);
+
+    auto total_hits = [](const std::vector<Particle>& ps) {
+        int total = 0;
+        for (const auto& p : ps) total += p.wallHits;
+        return total;
+    };
+
+    // Baseline: threads created and joined every step
+    std::vector<Particle> spawned = initial;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int step = 0; step < config.numSteps; step++) {
+        spawn_per_step_update(spawned, config.dt, config.numThreads);
+    }
+    auto t1 = std::chrono::steady_clock::now();
 
-            if (i == NUM_THREADS - 1) // Ensure the last thread covers the remaining particles
-            {
-                end = NUM_PARTICLES; // Start the thread for updating particles
-            }
+    // Persistent pool: threads created once, one barrier per step
+    std::vector<Particle> pooled = initial;
+    auto t2 = std::chrono::steady_clock::now();
+    {
+        WorkerPool pool(config.numThreads);
+        for (int step = 0; step < config.numSteps; step++) {
+            pool.runStep(pooled.size(), [&](size_t start, size_t end) {
+                update_particles(pooled, config.dt, start, end);
+            });
+        }
+    }
+    auto t3 = std::chrono::steady_clock::now();
 
-            threads[i] = std::thread(update_particles, std::ref(particles), DT, start, end);
+    double spawnSeconds = std::chrono::duration<double>(t1 - t0).count();
+    double poolSeconds = std::chrono::duration<double>(t3 - t2).count();
 
-        }
+    std::cout << "Step throughput (" << config.numParticles << " particles, " << config.numThreads << " threads, " << config.numSteps << " steps)\n";
+    std::cout << "  spawn-per-step: " << config.numSteps / spawnSeconds << " steps/s, wallHits=" << total_hits(spawned) << std::endl;
+    std::cout << "  worker pool:    " << config.numSteps / poolSeconds << " steps/s, wallHits=" << total_hits(pooled) << std::endl;
+    std::cout << "  speedup:        " << spawnSeconds / poolSeconds << "x" << std::endl;
+}
 
-        for (auto& t : threads) // Join threads after their completion
-        {
-            if (t.joinable()) // Wait for the thread to finish
-            {
-                t.join();
-            }
-        }
+// Compares the array-of-structs Particle::update kernel with the SoA/SIMD kernel on one core.
+// Both start from the same initial state; the final positions, velocities and wall hits must be identical.
+void benchmark_soa_kernel(const ParticleSimConfig& config) {
+    size_t numParticles = config.numParticles;
+    int numSteps = config.numSteps;
+    std::vector<Particle> aos(numParticles);
+    for (size_t i = 0; i < numParticles; i++) aos[i] = Particle(static_cast<int>(i));
+    initialize_particles(aos);
+    ParticleSoA soa(aos);
+    float dt = config.dt;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int step = 0; step < numSteps; step++) update_particles(aos, dt, 0, aos.size());
+    auto t1 = std::chrono::steady_clock::now();
+    for (int step = 0; step < numSteps; step++) update_particles_soa(soa, dt, 0, soa.size());
+    auto t2 = std::chrono::steady_clock::now();
+
+    long long aosHits = 0, soaHits = 0;
+    size_t mismatches = 0;
+    for (size_t i = 0; i < numParticles; i++) {
+        aosHits += aos[i].wallHits;
+        soaHits += soa.wallHits[i];
+        if (aos[i].x != soa.x[i] || aos[i].y != soa.y[i] || aos[i].vx != soa.vx[i] || aos[i].vy != soa.vy[i] || aos[i].wallHits != soa.wallHits[i]) mismatches++;
+    }
+
+    double aosSeconds = std::chrono::duration<double>(t1 - t0).count();
+    double soaSeconds = std::chrono::duration<double>(t2 - t1).count();
+    double updates = static_cast<double>(numParticles) * numSteps;
 
-        std::cout << "\x1B[2J\x1B[H"; // Clear the console for the next visualization
+    std::cout << "Kernel comparison (" << numParticles << " particles, " << numSteps << " steps, 1 thread)\n";
+    std::cout << "  AoS scalar:   " << updates / aosSeconds / 1e6 << " M particle-steps/s, wallHits=" << aosHits << std::endl;
+    std::cout << "  SoA " << soa_kernel_isa() << ": " << updates / soaSeconds / 1e6 << " M particle-steps/s, wallHits=" << soaHits << std::endl;
+    std::cout << "  speedup:      " << aosSeconds / soaSeconds << "x, mismatching particles=" << mismatches << std::endl;
+}
 
-        visualize_particles(particles, WIDTH, HEIGHT); // Visualize particles on the grid
+// Runs the visualised particle simulation and checks the reference result.
+void run_part2_test() {
+    std::vector<Particle> pars = parallel_moving_particles(); // Call the function to run the parallel particle simulation
+    int total_number_of_wallHits =test_particles_sim(pars);
+    std::cout << "If your Part 2 simulation is correct, then you should get a total number of wall hits equal to 49\n";
+    std::cout << "Your Part2 Results:\n  total_number_of_wallHits=" << total_number_of_wallHits <<"\n\n";
+}
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));// Wait for a short time before the next update
+int main(int argc, char* argv[]) {
+    ParticleSimConfig config; // Defaults come from the constants in Trains_and_Particles.h
+    if (!parse_command_line(argc, argv, config)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    configure_logging(config.logging); // Before anything logs
+    MetricsReport metrics(config.metricsPath); // --metrics: record timings and write them as JSON when main returns
+    if (config.mode == "part2") { // Test Part 2: visualised particle simulation
+        run_part2_test();
+        return 0;
+    }
+    if (config.mode == "run") { // Single headless run with checkpoint/resume and trajectory output
+        run_resumable_simulation(config);
+        return 0;
+    }
+    if (config.mode == "network") { // Data-driven railway model with N trains and M sections
+        run_network_simulation(config);
+        return 0;
+    }
+    if (config.mode == "validate-log") { // Streaming validation of a binary event log
+        run_event_log_validation(config);
+        return 0;
+    }
+    if (config.mode == "domain") { // Tiles of the box simulated by separate processes over shared memory
+        run_domain_simulation(config);
+        return 0;
+    }
+    if (config.mode == "headless") { // Headless particle benchmark: no rendering, no sleeping
+        run_headless_benchmark(config);
+        return 0;
+    }
+    if (config.mode == "bench-pool") { // Spawn-per-step threads vs the persistent worker pool
+        benchmark_step_throughput(config);
+        return 0;
+    }
+    if (config.mode == "bench-render") { // Allocation-free frame renderer throughput
+        run_render_benchmark(config);
+        return 0;
+    }
+    if (config.mode == "bench-pipeline") { // Compute, stats and render one after the other vs pipelined
+        run_pipeline_benchmark(config);
+        return 0;
+    }
+    if (config.mode == "bench-steal") { // Static split vs work stealing on skewed workloads
+        run_stealing_benchmark(config);
+        return 0;
+    }
+    if (config.mode == "bench-align") { // Packed vs cache-line-aligned worker ranges and counters
+        run_alignment_benchmark(config);
+        return 0;
+    }
+    if (config.mode == "bench-init") { // Serial vs parallel initialisation of the particles
+        run_init_benchmark(config);
+        return 0;
+    }
+    if (config.mode == "bench-fastforward") { // Fixed steps vs jumping from wall hit to wall hit
+        run_fastforward_benchmark(config);
+        return 0;
+    }
+    if (config.mode == "bench-morton") { // Random vs Morton-ordered particle storage in the spatial passes
+        run_morton_benchmark(config);
+        return 0;
+    }
+    if (config.mode == "bench-kernels") { // Every dimension / scalar / boundary instantiation of the template kernel
+        run_kernels_benchmark(config);
+        return 0;
+    }
+    if (config.mode == "bench-tracklock") { // Shared-section wait times and throughput under each locking policy
+        run_track_lock_benchmark(config);
+        return 0;
+    }
+    if (config.mode == "bench-soa") { // AoS scalar kernel vs the SoA/SIMD kernel
+        benchmark_soa_kernel(config);
+        return 0;
     }
-    return particles; // return the particles
-    return pars;
-}
 
-int main() {
     log("Simulation started."); // Log message indicating the start of the simulation
     //-----------------------------------------------------------Test Part 1: Trains ------------------------------------------------------------------//
    // To test Part 1, comment out the code specified below. Note that in the main function, you should comment out either the code for testing Part 1 or the code for testing Part 2, but not both at the same time.
     int numSimulationSteps = 43; // Define the number of steps you want the simulation to run
 
-    RailwaySystem railwaySystem;
+    RailwaySystem railwaySystem(config.trackLock); // --track-lock picks the guard of the shared section (std::mutex by default)
     railwaySystem.startSimulation(numSimulationSteps);
 
 
@@ -372,13 +556,7 @@ int main() {
 
 
     //------------------------------------------------------------Test Part 2: Moving Particles --------------------------------------------------------//
-    //To test Part 2, comment out the code specified below. Note that in the main function, you should comment out either the code for testing Part 1 or the code for testing Part 2, but not both at the same time.
-
-    /*std::vector<Particle> pars = parallel_moving_particles(); // Call the function to run the parallel particle simulation
-    int total_number_of_wallHits =test_particles_sim(pars);
-    std::cout << "If your Part 2 simulation is correct, then you should get a total number of wall hits equal to 49\n";
-    std::cout << "Your Part2 Results:\n  total_number_of_wallHits=" << total_number_of_wallHits <<"\n\n";
-    */
+    // To test Part 2, run the program with --part2 (see run_part2_test() and print_usage()).
 
 
     // Other outputs for Part2 implementatioin - Depending on the operating system's scheduling of the threads, your results might differ slightly from those shown below. However, the total number of wall hits should still be the same, at 49."
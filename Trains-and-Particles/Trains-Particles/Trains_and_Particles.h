@@ -10,9 +10,18 @@
 
 #include <vector>
 #include <mutex>
+#include <condition_variable>
 #include <thread>
+#include <stop_token>
+#include <chrono>
 #include <string>
 #include <iostream>
+#include <random>
+#include <memory>
+#include "TrainEventLog.h"
+#include "Gate.h"
+#include "Instrumentation.h"
+#include "TrackLock.h"
 #include <vector>
 #include <string>
 
@@ -27,10 +36,10 @@
    * - "Train A- L": Train A has left the shared track.
    * This log is used for verifying the correct sequence of events in the train simulation.
    */
-std::vector<std::string> trains_log;
+inline std::vector<std::string> trains_log;
 
  // Part1:
-bool isSimulationCorrect(const std::vector<std::string>& log, std::string& reason, int& record_number) {
+inline bool isSimulationCorrect(const std::vector<std::string>& log, std::string& reason, int& record_number) {
     // Flags to keep track of the state of each train
     bool isTrainAOnTrack = false, isTrainBOnTrack = false;
     bool flagTrainA = false; // Flag to check if Train A has moved
@@ -121,27 +130,38 @@ bool isSimulationCorrect(const std::vector<std::string>& log, std::string& reaso
 // Part1: Class RailwaySystem simulates two trains sharing a track segment.
 class RailwaySystem {
 public:
-    RailwaySystem(); // Constructor: Initializes the positions and shared section of the tracks.
-    void startSimulation(int numSteps); // Starts the simulation of the trains. It gets a parameter for the number of steps
+    explicit RailwaySystem(TrackLockPolicy policy = TrackLockPolicy::Mutex); // Constructor: Initializes the positions and shared section of the tracks, guarded with the given policy.
+    ~RailwaySystem(); // Destructor: Stops and joins any train thread still running.
+    void startSimulation(int numSteps); // Starts the simulation of the trains and returns once every train thread has been joined. It gets a parameter for the number of steps
+    void stop(); // Asks a running simulation to end early (safe from any thread); startSimulation() then returns promptly.
 
 private:
     int simulationSteps; // Stores the number of simulation steps
-    void trainA(); // Simulates the behavior of Train A.
-    void trainB(); // Simulates the behavior of Train B.
-    void trainC(); // Simulates the behavior of Train C.
+    void trainA(std::stop_token stop); // Simulates the behavior of Train A.
+    void trainB(std::stop_token stop); // Simulates the behavior of Train B.
+    void trainC(std::stop_token stop); // Simulates the behavior of Train C.
+    void joinTrains(); // Joins the train threads that are still joinable.
     void enterSharedTrack(const std::string& trainName); // Manages a train entering the shared track.
     void onSharedTrack(const std::string& trainName); // Manages a train currently on the shared track.
     void leaveSharedTrack(const std::string& trainName); // Manages a train leaving the shared track.
     void displayTracks(); // Displays the current state of the tracks and trains.
+    uint32_t trainIndex(const std::string& trainName) const; // Index of a train in trainNames, for the event recorder.
+    bool sleepUnlessStopped(const std::stop_token& stop, std::chrono::milliseconds duration); // Sleeps unless stop is requested first; false if cut short.
 
-    std::mutex sharedTrackMutex; // Mutex for synchronizing access to the shared track section.
-    int positionA, positionB, positionC; // Positions of Train A, Train B and Train C on their respective tracks.
-   
-    bool canMoveC; // Add this line to control trainC's movement
-    std::condition_variable cvC; // Add this for signaling trainC
-    std::mutex mtxC; // Mutex for trainC condition variable
+    std::unique_ptr<TrackLock> sharedTrackLock; // Guard of the shared track section, one train at a time (wait and hold times are measured).
+    std::atomic<int> positionA, positionB, positionC; // Positions of Train A, Train B and Train C (read by displayTracks while the trains move).
+
+    Gate gateC; // Opened by Train A to let trainC move, closed by Train B to stop it
+    std::stop_source stopSource; // Stop state of the current run, shared by every train thread
+    std::mutex lifecycleMutex; // Protects stopSource between stop() and the start of a run
+    std::jthread threadA, threadB, threadC; // Train threads of the current run
+    std::mutex sleepMutex; // Paired with sleepWake for the interruptible sleeps of the trains and the display loop
+    std::condition_variable_any sleepWake; // Never notified: only a stop request or the timeout ends a sleep
 
     int sharedSectionStart, sharedSectionEnd; // Start and end points of the shared track section.
+
+    std::vector<std::string> trainNames; // Names used in trains_log, indexed by train id
+    EventRecorder recorder; // Lock-free per-thread event buffers, merged into trains_log by startSimulation
 };
 
 //----------------------------------------------------------------------------------------------------------------
@@ -153,6 +173,7 @@ const int WIDTH = 40; // Width of the visualization grid
 const int HEIGHT = 20; // Height of the visualization grid
 const int NUM_STEPS = 200; // Total number of steps in the simulation
 const size_t NUM_THREADS = 10; // std::thread::hardware_concurrency(); // Number of threads used for parallel processing
+const float COLLISION_RADIUS = 0.0f; // Radius of each particle for particle-particle collisions (0 disables them)
 
 
 
@@ -163,21 +184,24 @@ public:
     float vx, vy; // Velocity of the particle
     int id; // Unique identifier for each particle
     int wallHits; // Number of times the particle hits a wall
+    int collisions; // Number of times the particle collided with another particle
 
-    Particle() : x(0), y(0), vx(0), vy(0), id(-1), wallHits(0) {} // Default constructor
+    Particle() : x(0), y(0), vx(0), vy(0), id(-1), wallHits(0), collisions(0) {} // Default constructor
     Particle(int id); // Constructor: Initializes a particle with a given ID.
     void update(float dt); // Updates the particle's position based on its velocity.
 };
 
 // Function declarations for particle simulation.
 void initialize_particles(std::vector<Particle>& particles); // Initializes the particles with random positions and velocities.
+void initialize_particles(std::vector<Particle>& particles, std::mt19937& gen); // Same, drawing from (and advancing) the given generator.
 void update_particles(std::vector<Particle>& particles, float dt, size_t start, size_t end); // Updates a range of particles.
+int update_particles_counted(std::vector<Particle>& particles, float dt, size_t start, size_t end); // Same, and returns the wall hits of this update.
 void visualize_particles(const std::vector<Particle>& particles, int width, int height); // Visualizes the particles on a grid.
 
 
 /**
  * Tests the particle simulation by checking the final state of each particle.
- * It outputs the simulation parameters and the wall hits for each particle.
+ * It outputs the simulation parameters and the wall hits and collisions for each particle.
  * The function then calculates and returns the total number of wall hits
  * encountered by all particles throughout the simulation.
  *
@@ -188,7 +212,7 @@ void visualize_particles(const std::vector<Particle>& particles, int width, int
  * Uncomment these lines if you want to enable runtime checks for these conditions.
  * Adjust the range for wall hit counts based on the expected behavior of your simulation.
  */
-int test_particles_sim(std::vector<Particle> particles) {
+inline int test_particles_sim(std::vector<Particle> particles) {
     // Output simulation parameters
     std::cout << " Part2 Results for parameters: \n";
     std::cout << "Number of Particles: " << NUM_PARTICLES << std::endl;
@@ -197,9 +221,11 @@ int test_particles_sim(std::vector<Particle> particles) {
     std::cout << "Grid Height: " << HEIGHT << std::endl;
     std::cout << "Number of Simulation Steps: " << NUM_STEPS << std::endl;
     std::cout << "Number of Threads: " << NUM_THREADS << std::endl;
+    std::cout << "Collision Radius: " << COLLISION_RADIUS << std::endl;
 
-    // Initialize total wall hits counter
+    // Initialize total wall hits and collisions counters
     int total_number_of_wallHits = 0;
+    int total_number_of_collisions = 0;
 
     // Iterate through each particle to check final state and wall hits
     for (const auto& particle : particles) {
@@ -208,13 +234,17 @@ int test_particles_sim(std::vector<Particle> particles) {
         //assert(particle.y >= -10 && particle.y <= 10);
         //assert(particle.wallHits >= 0 && particle.wallHits <= 20);
 
-        // Output individual particle ID and wall hit count
-        std::cout << "P-ID=" << particle.id << ", wallHits=" << particle.wallHits << std::endl;
+        // Output individual particle ID, wall hit count and collision count
+        std::cout << "P-ID=" << particle.id << ", wallHits=" << particle.wallHits << ", collisions=" << particle.collisions << std::endl;
 
-        // Accumulate total number of wall hits
+        // Accumulate total number of wall hits and collisions
         total_number_of_wallHits += particle.wallHits;
+        total_number_of_collisions += particle.collisions;
     }
 
+    // Every collision is counted on both particles
+    std::cout << "total_number_of_collisions=" << total_number_of_collisions / 2 << std::endl;
+
     // Return total wall hits for validation
     return total_number_of_wallHits;
 }
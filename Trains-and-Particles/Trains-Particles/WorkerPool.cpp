@@ -0,0 +1,210 @@
+/**
+ * @file WorkerPool.cpp
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+
+#include "WorkerPool.h"
+#include <algorithm>
+#include <numeric>
+#include "Instrumentation.h"
+
+// Splits [0, count) into numParts ranges; the last part covers the remaining items.
+void partition_range(size_t part, size_t numParts, size_t count, size_t& start, size_t& end) {
+    size_t step_size = count / numParts; // Number of items each part should handle
+    start = part * step_size; // Start index for this part
+    end = (part == numParts - 1) ? count : (part + 1) * step_size; // Last part covers the remainder
+}
+
+// Rounds each ideal boundary to the nearest item that starts a cache line.
+void partition_range_aligned(size_t part, size_t numParts, size_t count, const void* base, size_t itemSize,
+                             size_t& start, size_t& end) {
+    const size_t block = CACHE_LINE_BYTES / std::gcd(CACHE_LINE_BYTES, itemSize); // Items between two aligned item starts
+    const uintptr_t address = reinterpret_cast<uintptr_t>(base);
+    size_t first = 0; // First item that starts a cache line
+    while (first < block && (address + first * itemSize) % CACHE_LINE_BYTES != 0) first++;
+    if (first == block) first = 0; // No item starts a line (base is oddly aligned): plain blocks
+
+    auto boundary = [&](size_t p) -> size_t {
+        if (p == 0) return 0;
+        if (p >= numParts) return count;
+        size_t ideal = count / numParts * p; // Where partition_range puts it
+        if (ideal < first) return 0;
+        return std::min(first + (ideal - first + block / 2) / block * block, count);
+    };
+    start = boundary(part);
+    end = boundary(part + 1);
+}
+
+// Starts the workers once; they sleep on cvStep until runStep() publishes work.
+WorkerPool::WorkerPool(size_t numThreads)
+    : currentTask(nullptr), currentCount(0), currentBase(nullptr), currentItemSize(0), generation(0), remaining(0), stopping(false), currentGrain(0),
+      itemsLeft(0), steals(0) {
+    if (numThreads == 0) numThreads = 1; // Always keep at least one worker
+    deques.reset(new WorkDeque[numThreads]);
+    workers.reserve(numThreads);
+    for (size_t i = 0; i < numThreads; i++) {
+        workers.emplace_back(&WorkerPool::workerLoop, this, i);
+    }
+}
+
+// Wakes every worker with the stop flag set and joins them.
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        stopping = true;
+    }
+    cvStep.notify_all();
+    for (auto& t : workers) {
+        if (t.joinable()) t.join();
+    }
+}
+
+// Runs a task that does not need the worker index.
+void WorkerPool::runStep(size_t count, const RangeTask& task) {
+    runIndexedStep(count, [&task](size_t, size_t start, size_t end) { task(start, end); });
+}
+
+// Publishes one step to all workers and waits until every range has been processed.
+void WorkerPool::runIndexedStep(size_t count, const IndexedRangeTask& task) {
+    TP_SCOPED_TIMER("pool.step"); // Publish, run and barrier: compare with pool.task for the overhead
+    std::unique_lock<std::mutex> lock(poolMutex);
+    currentTask = &task;
+    currentCount = count;
+    currentItemSize = 0;
+    currentGrain = 0; // Static split
+    remaining = workers.size();
+    generation++; // New step: workers waiting on the previous generation wake up
+    cvStep.notify_all();
+    cvDone.wait(lock, [this] { return remaining == 0; }); // Barrier: the step is complete when all workers report back
+    currentTask = nullptr;
+}
+
+// Same step protocol as runIndexedStep; only the ranges differ.
+void WorkerPool::runAlignedStep(const void* base, size_t itemSize, size_t count, const IndexedRangeTask& task) {
+    TP_SCOPED_TIMER("pool.step");
+    std::unique_lock<std::mutex> lock(poolMutex);
+    currentTask = &task;
+    currentCount = count;
+    currentBase = base;
+    currentItemSize = itemSize;
+    currentGrain = 0;
+    remaining = workers.size();
+    generation++;
+    cvStep.notify_all();
+    cvDone.wait(lock, [this] { return remaining == 0; });
+    currentTask = nullptr;
+}
+
+// Seeds every deque with that worker's static range, then publishes the step like runIndexedStep.
+void WorkerPool::runStealingStep(size_t count, const IndexedRangeTask& task, size_t grain) {
+    const size_t numWorkers = workers.size();
+    if (grain == 0) grain = std::max<size_t>(count / (8 * numWorkers), 1);
+    TP_SCOPED_TIMER("pool.stealing_step");
+
+    std::unique_lock<std::mutex> lock(poolMutex);
+    for (size_t w = 0; w < numWorkers; w++) { // Workers are idle between steps, so no deque lock is needed
+        size_t start, end;
+        partition_range(w, numWorkers, count, start, end);
+        deques[w].chunks.clear();
+        if (start < end) deques[w].chunks.push_back({ start, end });
+    }
+    itemsLeft.store(count, std::memory_order_relaxed); // Published to the workers by poolMutex
+    currentTask = &task;
+    currentCount = count;
+    currentItemSize = 0;
+    currentGrain = grain;
+    remaining = numWorkers;
+    generation++;
+    cvStep.notify_all();
+    cvDone.wait(lock, [this] { return remaining == 0; });
+    currentTask = nullptr;
+}
+
+bool WorkerPool::popOwn(size_t index, Chunk& chunk) {
+    WorkDeque& own = deques[index];
+    std::lock_guard<std::mutex> lock(own.dequeMutex);
+    if (own.chunks.empty()) return false;
+    chunk = own.chunks.back();
+    own.chunks.pop_back();
+    return true;
+}
+
+bool WorkerPool::stealFrom(size_t index, Chunk& chunk) {
+    const size_t numWorkers = workers.size();
+    for (size_t k = 1; k < numWorkers; k++) { // Victims in order after this worker, so thieves spread out
+        WorkDeque& victim = deques[(index + k) % numWorkers];
+        std::lock_guard<std::mutex> lock(victim.dequeMutex);
+        if (victim.chunks.empty()) continue;
+        chunk = victim.chunks.front();
+        victim.chunks.pop_front();
+        steals.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+// Runs chunks until every item of the step is done. A chunk larger than grain is halved and the
+// upper half goes back on this worker's deque, where it can be stolen; chunks therefore shrink
+// only as far as the work needs, and a stolen half is split again by the thief.
+void WorkerPool::runChunks(size_t index, const IndexedRangeTask& task, size_t grain) {
+    Chunk chunk;
+    while (true) {
+        if (popOwn(index, chunk) || stealFrom(index, chunk)) {
+            while (chunk.end - chunk.start > grain) {
+                size_t mid = chunk.start + (chunk.end - chunk.start) / 2;
+                {
+                    std::lock_guard<std::mutex> lock(deques[index].dequeMutex);
+                    deques[index].chunks.push_back({ mid, chunk.end });
+                }
+                chunk.end = mid;
+            }
+            task(index, chunk.start, chunk.end);
+            itemsLeft.fetch_sub(chunk.end - chunk.start, std::memory_order_acq_rel);
+        }
+        else if (itemsLeft.load(std::memory_order_acquire) == 0) {
+            return; // Every chunk has been run, not only taken
+        }
+        else {
+            std::this_thread::yield(); // Others still run chunks that may be split and stolen
+        }
+    }
+}
+
+// Each worker waits for a new generation, runs its own range and reports completion.
+void WorkerPool::workerLoop(size_t index) {
+    uint64_t seen = 0; // Last generation this worker has processed
+    while (true) {
+        const IndexedRangeTask* task;
+        size_t count, grain, itemSize;
+        const void* base;
+        {
+            std::unique_lock<std::mutex> lock(poolMutex);
+            cvStep.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            task = currentTask;
+            count = currentCount;
+            grain = currentGrain;
+            base = currentBase;
+            itemSize = currentItemSize;
+        }
+
+        if (grain > 0) {
+            TP_SCOPED_TIMER("pool.task");
+            runChunks(index, *task, grain); // Work happens outside the lock
+        }
+        else {
+            size_t start, end;
+            if (itemSize > 0) partition_range_aligned(index, workers.size(), count, base, itemSize, start, end);
+            else partition_range(index, workers.size(), count, start, end);
+            TP_SCOPED_TIMER("pool.task"); // Per thread: shows how evenly the step was split
+            if (start < end) (*task)(index, start, end); // Work happens outside the lock
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            if (--remaining == 0) cvDone.notify_one(); // Last worker releases runStep()
+        }
+    }
+}
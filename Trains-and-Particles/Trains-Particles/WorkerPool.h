@@ -0,0 +1,105 @@
+/**
+ * @file WorkerPool.h
+ * @mini_project Trains_and_Particles
+ * @module CMP202
+ */
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+// Splits [0, count) into numParts contiguous ranges the same way parallel_moving_particles always has:
+// every part gets count / numParts items and the last part also takes the remainder.
+void partition_range(size_t part, size_t numParts, size_t count, size_t& start, size_t& end);
+
+const size_t CACHE_LINE_BYTES = 64; // Cache line size of the x86-64 and ARM64 cores we run on
+
+// As partition_range, but each boundary between two parts is moved to the nearest cache-line
+// boundary of the items (stored from base, itemSize bytes each), so no cache line is written
+// by two parts. With few items per part some parts may get an empty range.
+void partition_range_aligned(size_t part, size_t numParts, size_t count, const void* base, size_t itemSize,
+                             size_t& start, size_t& end);
+
+// One worker's accumulator on a cache line of its own. Counters that every worker bumps in its
+// inner loop would otherwise share lines, and each increment would steal the line from the others.
+template <typename T>
+struct alignas(CACHE_LINE_BYTES) PerWorker {
+    T value{};
+};
+
+// WorkerPool keeps a fixed set of threads alive for the whole simulation.
+// Each call to runStep() hands every worker its [start,end) range of the step and
+// blocks until all workers have finished (a barrier between steps), so no threads
+// are created or joined inside the step loop.
+//
+// runStealingStep() balances uneven work instead: every worker starts on its static range but
+// keeps it in its own deque of chunks, splitting the range in half until a chunk is small enough
+// to run. Idle workers steal the largest chunk left in another worker's deque, so a worker that
+// draws the expensive items no longer holds up the whole step.
+class WorkerPool {
+public:
+    using RangeTask = std::function<void(size_t start, size_t end)>; // Work done by one worker on its range.
+    using IndexedRangeTask = std::function<void(size_t worker, size_t start, size_t end)>; // Same, plus the worker's index (0..size()-1).
+
+    explicit WorkerPool(size_t numThreads); // Constructor: Starts numThreads workers that wait for steps.
+    ~WorkerPool(); // Destructor: Stops and joins all workers.
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void runStep(size_t count, const RangeTask& task); // Runs task over [0, count) split across the workers and waits for all of them.
+    void runIndexedStep(size_t count, const IndexedRangeTask& task); // As runStep, for tasks that keep per-worker state.
+    void runAlignedStep(const void* base, size_t itemSize, size_t count, const IndexedRangeTask& task); // As runIndexedStep, with partition_range_aligned ranges.
+    template <typename T>
+    void runAlignedStep(const std::vector<T>& items, const IndexedRangeTask& task) { runAlignedStep(items.data(), sizeof(T), items.size(), task); }
+    // As runIndexedStep, but with work stealing: task is called on chunks of at most grain items
+    // (0 = count / (8 * size()), at least 1), and a worker may run several non-contiguous chunks.
+    void runStealingStep(size_t count, const IndexedRangeTask& task, size_t grain = 0);
+    uint64_t stealCount() const { return steals.load(std::memory_order_relaxed); } // Chunks taken from another worker's deque so far.
+    size_t size() const { return workers.size(); } // Number of worker threads.
+
+private:
+    struct Chunk {
+        size_t start, end; // Items [start,end) not yet processed
+    };
+
+    // Chunks a worker still has to run. The owner takes from the back (the small chunks next to
+    // the one it just ran); thieves take from the front (the largest chunk, split off first).
+    struct alignas(64) WorkDeque {
+        std::mutex dequeMutex; // Protects chunks; only contended when somebody steals
+        std::deque<Chunk> chunks;
+    };
+
+    void workerLoop(size_t index); // Body of each worker thread.
+    void runChunks(size_t index, const IndexedRangeTask& task, size_t grain); // Stealing loop of one worker.
+    bool popOwn(size_t index, Chunk& chunk); // Takes the newest chunk of worker index's deque.
+    bool stealFrom(size_t index, Chunk& chunk); // Takes the oldest chunk of any other worker's deque.
+
+    std::vector<std::thread> workers; // Long-lived worker threads.
+    std::mutex poolMutex; // Protects the step state below.
+    std::condition_variable cvStep; // Signals workers that a new step (or shutdown) is ready.
+    std::condition_variable cvDone; // Signals runStep() that the last worker has finished.
+
+    const IndexedRangeTask* currentTask; // Task of the current step (owned by the caller of runStep).
+    size_t currentCount; // Number of items in the current step.
+    const void* currentBase; // Aligned steps: address of the first item.
+    size_t currentItemSize; // Aligned steps: bytes per item; 0 for the plain static split.
+    uint64_t generation; // Incremented once per step so workers can tell steps apart.
+    size_t remaining; // Workers still busy with the current step.
+    bool stopping; // Set by the destructor to make the workers exit.
+    size_t currentGrain; // Largest chunk of a stealing step; 0 for a static step.
+
+    std::unique_ptr<WorkDeque[]> deques; // One per worker, used by stealing steps
+    std::atomic<size_t> itemsLeft; // Items of the current stealing step not yet processed
+    std::atomic<uint64_t> steals; // Counter behind stealCount()
+};
+
+#endif // WORKER_POOL_H
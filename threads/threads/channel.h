@@ -0,0 +1,411 @@
+// Bounded lock-free channels for passing items between threads
+// Generalises the result/result_ready handoff in threads.cpp to a stream of items
+
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// Size of a cache line; head and tail live on separate lines so producers and consumers
+// don't keep invalidating each other's cache
+constexpr size_t CACHE_LINE = 64;
+
+// How many times a blocking push/pop retries before it goes to sleep
+constexpr int CHANNEL_SPINS = 64;
+
+// Rounds n up to a power of two (at least 2), so ring positions can be masked instead of divided
+inline size_t channel_capacity(size_t n)
+{
+	size_t capacity = 2;
+	while (capacity < n)
+	{
+		capacity *= 2;
+	}
+	return capacity;
+}
+
+// Blocking fallback used when a channel stays full or empty for a while.
+// Waiters register before re-checking the channel, and the other side only touches the
+// event (a futex on Linux, WaitOnAddress on Windows) when somebody is registered, so the
+// fast path costs one load.
+class EventCount
+{
+public:
+	// Called by a waiter before re-checking its condition
+	uint32_t prepare()
+	{
+		waiters.fetch_add(1, std::memory_order_seq_cst);
+		std::atomic_thread_fence(std::memory_order_seq_cst); // Pairs with the fence in notify()
+		return epoch.load(std::memory_order_seq_cst);
+	}
+
+	// Called by a waiter whose re-check failed: sleeps until notify() after prepare()
+	void wait(uint32_t ticket)
+	{
+		epoch.wait(ticket, std::memory_order_seq_cst);
+		waiters.fetch_sub(1, std::memory_order_seq_cst);
+	}
+
+	// Called by a waiter whose re-check succeeded
+	void cancel()
+	{
+		waiters.fetch_sub(1, std::memory_order_seq_cst);
+	}
+
+	// Called after changing the condition: wakes everybody who is waiting
+	void notify()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst); // Order the change before reading waiters
+		if (waiters.load(std::memory_order_relaxed) != 0)
+		{
+			epoch.fetch_add(1, std::memory_order_seq_cst);
+			epoch.notify_all();
+		}
+	}
+
+private:
+	std::atomic<uint32_t> epoch{0};
+	std::atomic<uint32_t> waiters{0};
+};
+
+// Common blocking/closing behaviour; Ring provides try_push, try_pop, push_batch and pop_batch
+template <typename Ring, typename T>
+class BlockingChannel
+{
+public:
+	// Pushes value, waiting while the channel is full. Returns false if the channel is closed.
+	bool push(const T& value)
+	{
+		Ring& ring = static_cast<Ring&>(*this);
+		for (int spin = 0; ; spin++)
+		{
+			if (closed.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+			if (ring.try_push(value))
+			{
+				notEmpty.notify();
+				return true;
+			}
+			if (spin < CHANNEL_SPINS)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			uint32_t ticket = notFull.prepare();
+			if (ring.try_push(value))
+			{
+				notFull.cancel();
+				notEmpty.notify();
+				return true;
+			}
+			if (closed.load(std::memory_order_acquire))
+			{
+				notFull.cancel();
+				return false;
+			}
+			notFull.wait(ticket);
+		}
+	}
+
+	// Pops into value, waiting while the channel is empty. Returns false once the channel
+	// is closed and empty.
+	bool pop(T& value)
+	{
+		Ring& ring = static_cast<Ring&>(*this);
+		for (int spin = 0; ; spin++)
+		{
+			if (ring.try_pop(value))
+			{
+				notFull.notify();
+				return true;
+			}
+			if (closed.load(std::memory_order_acquire))
+			{
+				// Recheck after seeing close(): the last push may have landed in between
+				if (ring.try_pop(value))
+				{
+					notFull.notify();
+					return true;
+				}
+				return false;
+			}
+			if (spin < CHANNEL_SPINS)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			uint32_t ticket = notEmpty.prepare();
+			if (ring.try_pop(value))
+			{
+				notEmpty.cancel();
+				notFull.notify();
+				return true;
+			}
+			if (closed.load(std::memory_order_acquire))
+			{
+				notEmpty.cancel();
+				continue; // Drain whatever was pushed before close()
+			}
+			notEmpty.wait(ticket);
+		}
+	}
+
+	// Pushes all count items, a batch at a time. Returns the number pushed (less than count
+	// only if the channel was closed).
+	size_t push_all(const T* items, size_t count)
+	{
+		Ring& ring = static_cast<Ring&>(*this);
+		size_t done = 0;
+		while (done < count)
+		{
+			size_t n = ring.push_batch(items + done, count - done);
+			if (n > 0)
+			{
+				done += n;
+				notEmpty.notify(); // One wake-up check per batch rather than per item
+			}
+			else if (!push(items[done])) // Full: fall back to the blocking path for one item
+			{
+				break;
+			}
+			else
+			{
+				done++;
+			}
+		}
+		return done;
+	}
+
+	// Pops up to max items, waiting until at least one is available. Returns 0 once the
+	// channel is closed and empty, or at once if max is 0.
+	size_t pop_some(T* items, size_t max)
+	{
+		if (max == 0)
+		{
+			return 0;
+		}
+		Ring& ring = static_cast<Ring&>(*this);
+		size_t n = ring.pop_batch(items, max);
+		if (n == 0)
+		{
+			if (!pop(items[0]))
+			{
+				return 0;
+			}
+			n = 1 + ring.pop_batch(items + 1, max - 1);
+		}
+		notFull.notify();
+		return n;
+	}
+
+	// No more pushes; consumers drain what is left and then see pop() return false
+	void close()
+	{
+		closed.store(true, std::memory_order_release);
+		notEmpty.notify();
+		notFull.notify();
+	}
+
+private:
+	std::atomic<bool> closed{false};
+	EventCount notEmpty; // Consumers waiting for items
+	EventCount notFull; // Producers waiting for space
+};
+
+// Single-producer single-consumer ring (Lamport queue). Each side keeps a cached copy of the
+// other side's index and only reloads it when the ring looks full or empty.
+template <typename T>
+class SpscChannel : public BlockingChannel<SpscChannel<T>, T>
+{
+public:
+	explicit SpscChannel(size_t minCapacity)
+		: capacity(channel_capacity(minCapacity)), mask(capacity - 1), slots(new T[capacity])
+	{
+	}
+
+	bool try_push(const T& value)
+	{
+		return push_batch(&value, 1) == 1;
+	}
+
+	bool try_pop(T& value)
+	{
+		return pop_batch(&value, 1) == 1;
+	}
+
+	// Pushes up to count items with a single release store of the tail
+	size_t push_batch(const T* items, size_t count)
+	{
+		size_t tail = producer.tail.load(std::memory_order_relaxed);
+		if (capacity - (tail - producer.cachedHead) < count)
+		{
+			producer.cachedHead = consumer.head.load(std::memory_order_acquire);
+		}
+		size_t space = capacity - (tail - producer.cachedHead);
+		size_t n = count < space ? count : space;
+		for (size_t i = 0; i < n; i++)
+		{
+			slots[(tail + i) & mask] = items[i];
+		}
+		if (n > 0)
+		{
+			producer.tail.store(tail + n, std::memory_order_release);
+		}
+		return n;
+	}
+
+	// Pops up to max items with a single release store of the head
+	size_t pop_batch(T* items, size_t max)
+	{
+		size_t head = consumer.head.load(std::memory_order_relaxed);
+		if (consumer.cachedTail - head < max)
+		{
+			consumer.cachedTail = producer.tail.load(std::memory_order_acquire);
+		}
+		size_t available = consumer.cachedTail - head;
+		size_t n = max < available ? max : available;
+		for (size_t i = 0; i < n; i++)
+		{
+			items[i] = slots[(head + i) & mask];
+		}
+		if (n > 0)
+		{
+			consumer.head.store(head + n, std::memory_order_release);
+		}
+		return n;
+	}
+
+private:
+	const size_t capacity;
+	const size_t mask;
+	std::unique_ptr<T[]> slots;
+
+	// Written by the producer only
+	struct alignas(CACHE_LINE) ProducerSide
+	{
+		std::atomic<size_t> tail{0};
+		size_t cachedHead = 0;
+	} producer;
+
+	// Written by the consumer only
+	struct alignas(CACHE_LINE) ConsumerSide
+	{
+		std::atomic<size_t> head{0};
+		size_t cachedTail = 0;
+	} consumer;
+};
+
+// Multi-producer multi-consumer ring (Dmitry Vyukov's bounded queue). Every slot carries a
+// sequence number that says whether it is ready to be written or read in the current lap,
+// so producers and consumers only compete on a compare-and-swap of their own index.
+template <typename T>
+class MpmcChannel : public BlockingChannel<MpmcChannel<T>, T>
+{
+public:
+	explicit MpmcChannel(size_t minCapacity)
+		: capacity(channel_capacity(minCapacity)), mask(capacity - 1), slots(new Slot[capacity])
+	{
+		for (size_t i = 0; i < capacity; i++)
+		{
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	bool try_push(const T& value)
+	{
+		size_t pos = tail.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Slot& slot = slots[pos & mask];
+			size_t sequence = slot.sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t) sequence - (intptr_t) pos;
+			if (diff == 0)
+			{
+				if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					slot.value = value;
+					slot.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				return false; // Full
+			}
+			else
+			{
+				pos = tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	bool try_pop(T& value)
+	{
+		size_t pos = head.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Slot& slot = slots[pos & mask];
+			size_t sequence = slot.sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t) sequence - (intptr_t) (pos + 1);
+			if (diff == 0)
+			{
+				if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					value = slot.value;
+					slot.sequence.store(pos + mask + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				return false; // Empty
+			}
+			else
+			{
+				pos = head.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// Slots are claimed one at a time; batching saves the wake-up checks
+	size_t push_batch(const T* items, size_t count)
+	{
+		size_t n = 0;
+		while (n < count && try_push(items[n]))
+		{
+			n++;
+		}
+		return n;
+	}
+
+	size_t pop_batch(T* items, size_t max)
+	{
+		size_t n = 0;
+		while (n < max && try_pop(items[n]))
+		{
+			n++;
+		}
+		return n;
+	}
+
+private:
+	struct Slot
+	{
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	const size_t capacity;
+	const size_t mask;
+	std::unique_ptr<Slot[]> slots;
+	alignas(CACHE_LINE) std::atomic<size_t> tail{0}; // Next position to write
+	alignas(CACHE_LINE) std::atomic<size_t> head{0}; // Next position to read
+};
+
+#endif
@@ -2,13 +2,18 @@
 // Adam Sampson <a.sampson@abertay.ac.uk>
 
 #include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
+#include "channel.h"
 
 // Import things we need from the standard library
 using std::chrono::seconds;
+using std::chrono::steady_clock;
+using std::chrono::duration;
 using std::cout;
 using std::endl;
 using std::ofstream;
@@ -17,6 +22,7 @@ using std::thread;
 using std::mutex;
 using std::condition_variable;
 using std::unique_lock;
+using std::vector;
 
 //global variables
 int result;
@@ -42,6 +48,180 @@ void consumer()
 	cout << "Result is " << result << endl;
 }
 
+// The producer/consumer handoff above, repeated for a stream of items:
+// one slot, guarded by a mutex, with a condition variable for each direction
+class HandoffSlot
+{
+public:
+	void push(int value)
+	{
+		unique_lock<mutex> lock(slot_mutex);
+		while (ready)
+		{
+			taken_cv.wait(lock);
+		}
+		slot = value;
+		ready = true;
+		ready_cv.notify_one();
+	}
+
+	int pop()
+	{
+		unique_lock<mutex> lock(slot_mutex);
+		while (!ready)
+		{
+			ready_cv.wait(lock);
+		}
+		ready = false;
+		taken_cv.notify_one();
+		return slot;
+	}
+
+private:
+	mutex slot_mutex;
+	condition_variable ready_cv;
+	condition_variable taken_cv;
+	int slot = 0;
+	bool ready = false;
+};
+
+// Prints one line of results: items per second, and whether every item arrived
+void report(const char *name, long long items, double secs, long long sum, long long expected)
+{
+	cout << "  " << name << ": " << (items / secs) / 1e6 << " M items/s ("
+		<< secs * 1000.0 << " ms)" << (sum == expected ? "" : "  WRONG SUM") << endl;
+}
+
+// Sum of 0..n-1, to check that nothing was lost or duplicated
+long long expected_sum(long long n)
+{
+	return n * (n - 1) / 2;
+}
+
+void bench_handoff(int items)
+{
+	HandoffSlot slot;
+	long long sum = 0;
+	auto start = steady_clock::now();
+	thread consumerThread([&] {
+		for (int i = 0; i < items; i++)
+		{
+			sum += slot.pop();
+		}
+	});
+	for (int i = 0; i < items; i++)
+	{
+		slot.push(i);
+	}
+	consumerThread.join();
+	report("mutex/cv handoff     ", items, duration<double>(steady_clock::now() - start).count(), sum, expected_sum(items));
+}
+
+void bench_spsc(int items, size_t batch)
+{
+	SpscChannel<int> channel(1024);
+	long long sum = 0;
+	auto start = steady_clock::now();
+	thread consumerThread([&] {
+		vector<int> buffer(batch);
+		size_t n;
+		while ((n = channel.pop_some(buffer.data(), batch)) > 0)
+		{
+			for (size_t i = 0; i < n; i++)
+			{
+				sum += buffer[i];
+			}
+		}
+	});
+	if (batch == 1)
+	{
+		for (int i = 0; i < items; i++)
+		{
+			channel.push(i);
+		}
+	}
+	else
+	{
+		vector<int> buffer(batch);
+		for (int i = 0; i < items; i += (int) batch)
+		{
+			size_t n = 0;
+			for (int j = i; j < items && n < batch; j++)
+			{
+				buffer[n++] = j;
+			}
+			channel.push_all(buffer.data(), n);
+		}
+	}
+	channel.close();
+	consumerThread.join();
+	report(batch == 1 ? "spsc channel         " : "spsc channel, batch 64", items, duration<double>(steady_clock::now() - start).count(), sum, expected_sum(items));
+}
+
+void bench_mpmc(int items, int producers, int consumers)
+{
+	MpmcChannel<int> channel(1024);
+	vector<long long> sums(consumers, 0);
+	auto start = steady_clock::now();
+	vector<thread> threads;
+	for (int c = 0; c < consumers; c++)
+	{
+		threads.emplace_back([&, c] {
+			int value;
+			while (channel.pop(value))
+			{
+				sums[c] += value;
+			}
+		});
+	}
+	vector<thread> producerThreads;
+	for (int p = 0; p < producers; p++)
+	{
+		producerThreads.emplace_back([&, p] {
+			for (int i = p; i < items; i += producers)
+			{
+				channel.push(i);
+			}
+		});
+	}
+	for (thread& t : producerThreads)
+	{
+		t.join();
+	}
+	channel.close();
+	for (thread& t : threads)
+	{
+		t.join();
+	}
+	long long sum = 0;
+	for (long long s : sums)
+	{
+		sum += s;
+	}
+	report("mpmc channel, 2p/2c  ", items, duration<double>(steady_clock::now() - start).count(), sum, expected_sum(items));
+}
+
+// Round trip: the main thread sends a value, an echo thread sends it straight back
+template <typename Send, typename Receive>
+void bench_round_trip(const char *name, int trips, Send send, Receive receive)
+{
+	thread echo([&] {
+		for (int i = 0; i < trips; i++)
+		{
+			send(1, receive(0));
+		}
+	});
+	auto start = steady_clock::now();
+	for (int i = 0; i < trips; i++)
+	{
+		send(0, i);
+		receive(1);
+	}
+	double secs = duration<double>(steady_clock::now() - start).count();
+	echo.join();
+	cout << "  " << name << ": " << (secs / trips) * 1e9 << " ns per round trip" << endl;
+}
+
 int main(int argc, char *argv[])
 {
 	thread producerThread(producer);
@@ -50,5 +230,24 @@ int main(int argc, char *argv[])
 	producerThread.join();
 	consumerThread.join();
 
+	// Throughput and latency of the handoff above against the lock-free channels
+	int items = argc > 1 ? atoi(argv[1]) : 1000000;
+	int trips = items / 20 > 0 ? items / 20 : 1;
+	cout << "Passing " << items << " items (" << thread::hardware_concurrency() << " hardware threads)" << endl;
+	bench_handoff(items);
+	bench_spsc(items, 1);
+	bench_spsc(items, 64);
+	bench_mpmc(items, 2, 2);
+
+	cout << "Round trips (" << trips << ")" << endl;
+	HandoffSlot slots[2];
+	bench_round_trip("mutex/cv handoff", trips,
+		[&](int dir, int value) { slots[dir].push(value); },
+		[&](int dir) { return slots[dir].pop(); });
+	SpscChannel<int> channels[2] = { SpscChannel<int>(16), SpscChannel<int>(16) };
+	bench_round_trip("spsc channel    ", trips,
+		[&](int dir, int value) { channels[dir].push(value); },
+		[&](int dir) { int value = 0; channels[dir].pop(value); return value; });
+
 	return 0;
 }